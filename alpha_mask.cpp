@@ -0,0 +1,89 @@
+#include "alpha_mask.h"
+#include "quad_batch.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ALPHA_MASK_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#define ALPHA_MASK_TARGET_SSE2
+#else
+#define ALPHA_MASK_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+namespace {
+    // Antialiased fringes below this alpha do not count as part of the sprite.
+    constexpr unsigned char OPAQUE_ALPHA = 16;
+
+    unsigned scan_scalar(const unsigned char* rgba, int count) {
+        unsigned bits = 0;
+        for (int i = 0; i < count; ++i) {
+            if (rgba[i * 4 + 3] >= OPAQUE_ALPHA) bits |= 1u << i;
+        }
+        return bits;
+    }
+
+#ifdef ALPHA_MASK_X86
+    // Sixteen texels: the alpha bytes are shifted down, packed into one
+    // register and compared at once.
+    ALPHA_MASK_TARGET_SSE2 unsigned scan_sse2(const unsigned char* rgba) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(rgba);
+        __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(src + 0), 24);
+        __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(src + 1), 24);
+        __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(src + 2), 24);
+        __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(src + 3), 24);
+        __m128i alpha = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+        __m128i below = _mm_cmpeq_epi8(_mm_subs_epu8(alpha, _mm_set1_epi8(OPAQUE_ALPHA - 1)), _mm_setzero_si128());
+        return ~(unsigned)_mm_movemask_epi8(below) & 0xFFFFu;
+    }
+#endif
+
+    unsigned scan(const unsigned char* rgba, int count, bool use_sse2) {
+#ifdef ALPHA_MASK_X86
+        if (use_sse2 && count == 16) return scan_sse2(rgba);
+#endif
+        return scan_scalar(rgba, count);
+    }
+
+    int lowest_bit(unsigned bits) {
+        int index = 0;
+        while (!(bits & 1u)) { bits >>= 1; ++index; }
+        return index;
+    }
+
+    int highest_bit(unsigned bits) {
+        int index = -1;
+        while (bits) { bits >>= 1; ++index; }
+        return index;
+    }
+}
+
+void AlphaMask::Build(const unsigned char* rgba, int width, int height, Mask& mask) {
+    mask.width = std::max(width, 0);
+    mask.height = std::max(height, 0);
+    mask.wordsPerRow = (mask.width + 63) / 64;
+    mask.bits.assign((size_t)mask.wordsPerRow * mask.height, 0);
+    mask.trimMinX = mask.width; mask.trimMinY = mask.height;
+    mask.trimMaxX = 0; mask.trimMaxY = 0;
+
+    const bool use_sse2 = QuadBatch::ActiveBackend() != QuadBatch::Backend::Scalar;
+    for (int y = 0; y < mask.height; ++y) {
+        const unsigned char* row = rgba + (size_t)y * mask.width * 4;
+        std::uint64_t* words = mask.bits.data() + (size_t)y * mask.wordsPerRow;
+        int first = -1, last = -1;
+        for (int x = 0; x < mask.width; x += 16) {
+            const unsigned bits = scan(row + (size_t)x * 4, std::min(16, mask.width - x), use_sse2);
+            if (!bits) continue;
+            words[x >> 6] |= (std::uint64_t)bits << (x & 63);
+            if (first < 0) first = x + lowest_bit(bits);
+            last = x + highest_bit(bits);
+        }
+        if (first < 0) continue;
+        mask.trimMinX = std::min(mask.trimMinX, first);
+        mask.trimMaxX = std::max(mask.trimMaxX, last + 1);
+        mask.trimMinY = std::min(mask.trimMinY, y);
+        mask.trimMaxY = y + 1;
+    }
+    if (mask.trimMaxX <= mask.trimMinX) mask.trimMinX = mask.trimMinY = mask.trimMaxX = mask.trimMaxY = 0;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AlphaMask {
+    // One bit per texel, set where the texel is opaque enough to pick, rows
+    // padded to whole 64-bit words and top row first. The trimmed rect is the
+    // smallest one holding every set bit, max exclusive; it is empty when the
+    // texture is fully transparent.
+    struct Mask {
+        int width = 0;
+        int height = 0;
+        int wordsPerRow = 0;
+        std::vector<std::uint64_t> bits;
+        int trimMinX = 0, trimMinY = 0, trimMaxX = 0, trimMaxY = 0;
+
+        bool Test(int x, int y) const {
+            if (x < 0 || y < 0 || x >= width || y >= height) return false;
+            return (bits[(size_t)y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1u;
+        }
+        bool Empty() const { return trimMaxX <= trimMinX || trimMaxY <= trimMinY; }
+    };
+
+    // Builds the mask of RGBA8 pixels; rows are scanned 16 texels at a time.
+    void Build(const unsigned char* rgba, int width, int height, Mask& mask);
+}
\ No newline at end of file
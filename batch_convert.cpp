@@ -0,0 +1,173 @@
+#include "batch_convert.h"
+#include "datatypes.h"
+#include "environment.h"
+#include "export.h"
+#include "file_handling.h"
+#include "image_decoder.h"
+#include "script_inputs.h"
+#include "thread_pool.h"
+#include "vfs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    using ScriptInputs::Input;
+
+    struct FileResult {
+        std::filesystem::path output;
+        std::string error;
+        double parseMs = 0, texturesMs = 0, exportMs = 0;
+        size_t sprites = 0, textures = 0;
+    };
+
+    struct TextureSize { int width, height; };
+
+    std::mutex g_sizeMutex;
+    std::unordered_map<std::string, TextureSize> g_sizes;
+
+    double ms_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    bool lookup_size(const std::filesystem::path& found_path, TextureSize& size, std::string& errorMessage) {
+        const std::string key = found_path.string();
+        {
+            std::lock_guard<std::mutex> lock(g_sizeMutex);
+            auto it = g_sizes.find(key);
+            if (it != g_sizes.end()) {
+                size = it->second;
+                return true;
+            }
+        }
+        if (!ImageDecoder::ReadSize(found_path, size.width, size.height, errorMessage)) return false;
+        std::lock_guard<std::mutex> lock(g_sizeMutex);
+        g_sizes[key] = size;
+        return true;
+    }
+
+    // Fills frame sizes and texturePaths from image headers, as the GUI loader
+    // would, so a missing or unreadable texture fails the file the same way.
+    bool resolve_textures(SpriteData& data, const std::vector<std::string>& searchPaths, std::string& errorMessage) {
+        for (auto& [sprite_name, sprite] : data.sprites) {
+            for (auto& [state_name, state] : sprite.states) {
+                for (auto& frame : state.frames) {
+                    auto known = data.texturePaths.find(frame.texturePath);
+                    std::filesystem::path found_path = known != data.texturePaths.end() ? std::filesystem::path(known->second) : Vfs::Resolve(frame.texturePath, searchPaths, SUPPORTED_IMAGE_EXTENSIONS);
+                    if (found_path.empty()) {
+                        errorMessage = "Image not found: " + frame.texturePath;
+                        return false;
+                    }
+                    TextureSize size;
+                    if (!lookup_size(found_path, size, errorMessage)) {
+                        errorMessage = found_path.string() + ": " + errorMessage;
+                        return false;
+                    }
+                    frame.width = size.width;
+                    frame.height = size.height;
+                    data.texturePaths[frame.texturePath] = found_path.string();
+                }
+            }
+        }
+        return true;
+    }
+
+    void convert(const Input& input, const std::filesystem::path& output, FileResult& result) {
+        result.output = output;
+        std::string script = std::filesystem::absolute(input.path).lexically_normal().string();
+        std::vector<std::string> search_paths = Environment::SearchPathsForFile(script);
+
+        Clock::time_point start = Clock::now();
+        SpriteData data;
+        bool parsed = parse_sprite_file(script, search_paths, data, result.error);
+        result.parseMs = ms_since(start);
+        if (!parsed) return;
+        result.sprites = data.sprites.size();
+
+        start = Clock::now();
+        bool resolved = resolve_textures(data, search_paths, result.error);
+        result.texturesMs = ms_since(start);
+        result.textures = data.texturePaths.size();
+        if (!resolved) return;
+
+        start = Clock::now();
+        std::error_code ec;
+        if (output.has_parent_path()) std::filesystem::create_directories(output.parent_path(), ec);
+        std::string success;
+        Export::SaveToFile(output.string(), data.root.get(), data.sprites, success, result.error);
+        result.exportMs = ms_since(start);
+    }
+
+    void print_usage() {
+        std::printf(
+            "Usage: PivotHelper --convert [--out <dir>] [--in-place] <script|glob|@list>...\n"
+            "  --out <dir>   write exports below <dir> (default: export)\n"
+            "  --in-place    overwrite each script with its export\n"
+            "Globs support '*', '?' and '**'; an @list file holds one input per line.\n");
+    }
+}
+
+int BatchConvert::Run(const std::vector<std::string>& args) {
+    std::filesystem::path out_dir = "export";
+    bool in_place = false;
+    std::vector<Input> inputs;
+    for (size_t i = 0; i < args.size(); ++i) {
+        std::string errorMessage;
+        if (args[i] == "--out" && i + 1 < args.size()) out_dir = args[++i];
+        else if (args[i] == "--in-place") in_place = true;
+        else if (args[i] == "--help" || args[i] == "-h") { print_usage(); return 0; }
+        else if (!ScriptInputs::Expand(args[i], inputs, errorMessage)) {
+            std::fprintf(stderr, "%s\n", errorMessage.c_str());
+            return 2;
+        }
+    }
+    if (inputs.empty()) {
+        print_usage();
+        return 2;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::set<std::string> roots;
+    for (const auto& input : inputs) {
+        for (auto& root : Environment::SearchPathsForFile(std::filesystem::absolute(input.path).lexically_normal().string())) roots.insert(root);
+    }
+    Vfs::IndexNow(std::vector<std::string>(roots.begin(), roots.end()));
+    double index_ms = ms_since(start);
+
+    std::vector<FileResult> results(inputs.size());
+    ThreadPool::ParallelFor(inputs.size(), [&](size_t i) {
+        const Input& input = inputs[i];
+        std::filesystem::path output = in_place ? input.path : out_dir / input.path.lexically_relative(input.base);
+        Clock::time_point file_start = Clock::now();
+        convert(input, output, results[i]);
+        double total_ms = ms_since(file_start);
+        const FileResult& result = results[i];
+        if (result.error.empty()) {
+            std::printf("%9.2f ms  %s -> %s (parse %.2f, textures %.2f, export %.2f)\n", total_ms, input.path.string().c_str(), result.output.string().c_str(), result.parseMs, result.texturesMs, result.exportMs);
+        }
+        else {
+            std::printf("%9.2f ms  %s FAILED: %s\n", total_ms, input.path.string().c_str(), result.error.c_str());
+        }
+    });
+    double total_s = ms_since(start) / 1000.0;
+
+    size_t failed = 0, sprites = 0;
+    double parse_ms = 0, textures_ms = 0, export_ms = 0;
+    for (const auto& result : results) {
+        if (!result.error.empty()) ++failed;
+        sprites += result.sprites;
+        parse_ms += result.parseMs;
+        textures_ms += result.texturesMs;
+        export_ms += result.exportMs;
+    }
+    std::printf("\nConverted %zu of %zu files (%zu sprites, %zu distinct textures) in %.2f s on %u threads: %.1f files/s\n",
+        inputs.size() - failed, inputs.size(), sprites, g_sizes.size(), total_s, ThreadPool::WorkerCount(), inputs.size() / std::max(total_s, 1e-6));
+    std::printf("Indexing %.2f ms; summed per-file time: parse %.2f ms, textures %.2f ms, export %.2f ms\n", index_ms, parse_ms, textures_ms, export_ms);
+    return failed == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace BatchConvert {
+    // Headless re-export of sprite scripts: PivotHelper --convert [options] <inputs>
+    // Inputs are script paths, globs ('*', '?', '**') or @list files with one
+    // input per line. Scripts are parsed and exported in parallel; textures
+    // are only resolved and their headers read for the size, never decoded.
+    // Returns the process exit code.
+    int Run(const std::vector<std::string>& args);
+}
\ No newline at end of file
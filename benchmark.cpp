@@ -0,0 +1,348 @@
+#include "benchmark.h"
+#include "datatypes.h"
+#include "export.h"
+#include "file_handling.h"
+#include "image_decoder.h"
+#include "pick_grid.h"
+#include "pivot_logic.h"
+#include "quad_batch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    constexpr double MIN_SECONDS = 0.25;
+    constexpr int MIN_ITERATIONS = 5;
+
+    struct Result {
+        std::string name;
+        size_t items = 0;   // work items per iteration (nodes, files, ...)
+        int iterations = 0;
+        double medianNs = 0, meanNs = 0, minNs = 0;
+    };
+
+    // Rig generators. Every node gets its own sprite with a Normal state and
+    // statesPerSprite - 1 extra states, so state lookups are not trivially small.
+    struct SyntheticRig {
+        SpriteData data;
+        size_t nodeCount = 0;
+    };
+
+    Sprite& add_sprite(SpriteData& data, int id, int statesPerSprite) {
+        Sprite sprite;
+        sprite.name = "sprite" + std::to_string(id);
+        for (int s = 0; s < statesPerSprite; ++s) {
+            SpriteState state;
+            SpriteFrame frame;
+            frame.textureId = 1;
+            frame.width = 32 + id % 17;
+            frame.height = 24 + id % 13;
+            frame.texturePath = "ui/textures/bench/" + sprite.name + "_" + std::to_string(s) + ".tga";
+            state.frames.assign(1 + s % 3, frame);
+            if (s > 0) state.nextState = "Normal";
+            sprite.states[s == 0 ? "Normal" : "State" + std::to_string(s)] = state;
+        }
+        auto it = data.sprites.emplace(sprite.name, std::move(sprite)).first;
+        return it->second;
+    }
+
+    std::unique_ptr<Node> make_node(SpriteData& data, int id, int statesPerSprite) {
+        auto node = std::make_unique<Node>();
+        node->name = "Node" + std::to_string(id);
+        Sprite& sprite = add_sprite(data, id, statesPerSprite);
+        node->spriteName = sprite.name;
+        node->sprite_ptr = &sprite;
+        node->pivot = { 0.25f + (id % 5) * 0.1f, 0.5f };
+        node->pivotOffset = { -0.5f, -0.25f };
+        node->angle = (float)(id * 7 % 360);
+        return node;
+    }
+
+    void make_chain(SyntheticRig& rig, int depth, int statesPerSprite) {
+        rig.data.root = make_node(rig.data, 0, statesPerSprite);
+        Node* tail = rig.data.root.get();
+        for (int i = 1; i < depth; ++i) {
+            auto& list = i % 2 ? tail->childrenInFront : tail->childrenBehind;
+            list.push_back(make_node(rig.data, i, statesPerSprite));
+            tail = list.back().get();
+        }
+        rig.nodeCount = depth;
+    }
+
+    void make_fan(SyntheticRig& rig, int width, int statesPerSprite) {
+        rig.data.root = make_node(rig.data, 0, statesPerSprite);
+        for (int i = 1; i < width; ++i) {
+            auto& list = i % 2 ? rig.data.root->childrenInFront : rig.data.root->childrenBehind;
+            list.push_back(make_node(rig.data, i, statesPerSprite));
+        }
+        rig.nodeCount = width;
+    }
+
+    // Balanced tree with the given fan-out, built breadth first.
+    void make_tree(SyntheticRig& rig, int count, int fanOut, int statesPerSprite) {
+        rig.data.root = make_node(rig.data, 0, statesPerSprite);
+        std::vector<Node*> open = { rig.data.root.get() };
+        int id = 1;
+        for (size_t next = 0; id < count; ++next) {
+            Node* parent = open[next];
+            for (int c = 0; c < fanOut && id < count; ++c, ++id) {
+                auto& list = c % 2 ? parent->childrenInFront : parent->childrenBehind;
+                list.push_back(make_node(rig.data, id, statesPerSprite));
+                open.push_back(list.back().get());
+            }
+        }
+        rig.nodeCount = count;
+    }
+
+    const SpriteFrame* normal_frame(const Node* node) {
+        if (!node->sprite_ptr) return nullptr;
+        auto it = node->sprite_ptr->states.find("Normal");
+        return it == node->sprite_ptr->states.end() || it->second.frames.empty() ? nullptr : &it->second.frames[0];
+    }
+
+    // The recursive walk the canvas used before rigs were compiled.
+    float walk_transforms(const Node* node, const Transform& parent_transform, const SpriteFrame* parent_frame) {
+        Transform transform = PivotLogic::CalculateWorldTransform(node, parent_transform, parent_frame);
+        const SpriteFrame* frame = normal_frame(node);
+        float sum = transform.position.x + transform.position.y;
+        for (const auto& child : node->childrenBehind) sum += walk_transforms(child.get(), transform, frame);
+        for (const auto& child : node->childrenInFront) sum += walk_transforms(child.get(), transform, frame);
+        return sum;
+    }
+
+    // Compile, pose and bound every drawn quad, as Canvas::Render does on a
+    // full rebuild.
+    float traverse_canvas(SpriteData& data, PivotLogic::CompiledRig& rig, std::vector<Transform>& transforms, QuadBatch::Batch& batch) {
+        PivotLogic::CompileRig(data.root.get(), "Normal", data.defaultState, 0, rig);
+        PivotLogic::EvaluatePose(rig, Transform(), transforms);
+        batch.Resize(rig.drawOrder.size());
+        for (size_t i = 0; i < rig.drawOrder.size(); ++i) {
+            const int index = rig.drawOrder[i];
+            const SpriteFrame& frame = *rig.drawFrame[index];
+            const Transform& transform = transforms[index];
+            batch.centerX[i] = transform.position.x; batch.centerY[i] = transform.position.y;
+            batch.halfWidth[i] = frame.width * 0.5f; batch.halfHeight[i] = frame.height * 0.5f;
+            batch.axisXx[i] = transform.matrix.a; batch.axisXy[i] = transform.matrix.b;
+            batch.axisYx[i] = transform.matrix.c; batch.axisYy[i] = transform.matrix.d;
+        }
+        QuadBatch::Compute(batch);
+        return batch.size() ? batch.maxX[0] : 0.0f;
+    }
+
+    void write_tga(const std::filesystem::path& path, int width, int height, bool rle) {
+        std::vector<unsigned char> out = { 0, 0, (unsigned char)(rle ? 10 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            (unsigned char)(width & 255), (unsigned char)(width >> 8), (unsigned char)(height & 255), (unsigned char)(height >> 8), 32, 8 };
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; x += rle ? 8 : 1) {
+                // RLE rows are runs of 8 equal pixels, which is typical of flat UI art.
+                if (rle) out.push_back(0x80 | 7);
+                unsigned char pixel[4] = { (unsigned char)(x * 3), (unsigned char)(y * 5), (unsigned char)(x ^ y), (unsigned char)(x < width / 2 ? 255 : 0) };
+                out.insert(out.end(), pixel, pixel + 4);
+            }
+        }
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(out.data()), out.size());
+    }
+
+    DecodedImage make_image(int width, int height) {
+        DecodedImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize((size_t)width * height * 4);
+        for (size_t i = 0; i < image.pixels.size(); ++i) image.pixels[i] = (unsigned char)((i * 2654435761u) >> 24);
+        return image;
+    }
+
+    class Runner {
+    public:
+        explicit Runner(std::string filter) : m_filter(std::move(filter)) {}
+
+        void Add(const std::string& name, size_t items, const std::function<void()>& body) {
+            if (!m_filter.empty() && name.find(m_filter) == std::string::npos) return;
+            body(); // warm-up
+            std::vector<double> samples;
+            Clock::time_point start = Clock::now();
+            while (samples.size() < (size_t)MIN_ITERATIONS || std::chrono::duration<double>(Clock::now() - start).count() < MIN_SECONDS) {
+                Clock::time_point t0 = Clock::now();
+                body();
+                samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+            }
+            std::sort(samples.begin(), samples.end());
+            Result result;
+            result.name = name;
+            result.items = items;
+            result.iterations = (int)samples.size();
+            result.medianNs = samples[samples.size() / 2];
+            result.minNs = samples.front();
+            for (double sample : samples) result.meanNs += sample;
+            result.meanNs /= samples.size();
+            std::printf("%-34s %10.3f ms median %10.3f ms min %8d iters %12.1f ns/item\n", name.c_str(),
+                result.medianNs / 1e6, result.minNs / 1e6, result.iterations, result.medianNs / std::max<size_t>(1, items));
+            m_results.push_back(result);
+        }
+
+        const std::vector<Result>& Results() const { return m_results; }
+
+    private:
+        std::string m_filter;
+        std::vector<Result> m_results;
+    };
+
+    bool write_json(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+        out << "{\n  \"backend\": \"" << QuadBatch::BackendName(QuadBatch::ActiveBackend()) << "\",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    { \"name\": \"" << r.name << "\", \"items\": " << r.items << ", \"iterations\": " << r.iterations
+                << ", \"median_ns\": " << (long long)r.medianNs << ", \"mean_ns\": " << (long long)r.meanNs << ", \"min_ns\": " << (long long)r.minNs << " }"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return true;
+    }
+
+    // Reads name -> median_ns back from a file written by write_json.
+    bool read_baseline(const std::string& path, std::map<std::string, double>& medians) {
+        std::ifstream in(path);
+        if (!in.is_open()) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t name_pos = line.find("\"name\": \"");
+            size_t median_pos = line.find("\"median_ns\": ");
+            if (name_pos == std::string::npos || median_pos == std::string::npos) continue;
+            name_pos += 9;
+            std::string name = line.substr(name_pos, line.find('"', name_pos) - name_pos);
+            medians[name] = std::atof(line.c_str() + median_pos + 13);
+        }
+        return true;
+    }
+}
+
+int Benchmark::Run(const std::vector<std::string>& args) {
+    std::string filter, json_path, baseline_path;
+    double tolerance = 10.0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--filter" && has_value) filter = args[++i];
+        else if (args[i] == "--json" && has_value) json_path = args[++i];
+        else if (args[i] == "--baseline" && has_value) baseline_path = args[++i];
+        else if (args[i] == "--tolerance" && has_value) tolerance = std::atof(args[++i].c_str());
+        else {
+            std::printf("Usage: PivotHelper --benchmark [--filter <text>] [--json <file>] [--baseline <file>] [--tolerance <percent>]\n");
+            return 2;
+        }
+    }
+
+    std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "pivothelper_bench";
+    std::error_code ec;
+    std::filesystem::create_directories(work_dir, ec);
+    Runner runner(filter);
+    volatile float sink = 0.0f;
+
+    // Pivot math
+    SyntheticRig chain, fan, tree;
+    make_chain(chain, 1000, 4);
+    make_fan(fan, 5000, 4);
+    make_tree(tree, 5000, 4, 16);
+    runner.Add("pivot.world_transform.chain1000", chain.nodeCount, [&] { sink = walk_transforms(chain.data.root.get(), Transform(), nullptr); });
+    runner.Add("pivot.world_transform.fan5000", fan.nodeCount, [&] { sink = walk_transforms(fan.data.root.get(), Transform(), nullptr); });
+    runner.Add("pivot.world_transform.tree5000", tree.nodeCount, [&] { sink = walk_transforms(tree.data.root.get(), Transform(), nullptr); });
+
+    // Canvas traversal
+    PivotLogic::CompiledRig compiled;
+    std::vector<Transform> transforms;
+    QuadBatch::Batch batch;
+    runner.Add("canvas.rebuild.chain1000", chain.nodeCount, [&] { sink = traverse_canvas(chain.data, compiled, transforms, batch); });
+    runner.Add("canvas.rebuild.fan5000", fan.nodeCount, [&] { sink = traverse_canvas(fan.data, compiled, transforms, batch); });
+    runner.Add("canvas.rebuild.tree5000", tree.nodeCount, [&] { sink = traverse_canvas(tree.data, compiled, transforms, batch); });
+    PivotLogic::CompileRig(tree.data.root.get(), "Normal", tree.data.defaultState, 0, compiled);
+    runner.Add("canvas.pose_only.tree5000", tree.nodeCount, [&] { PivotLogic::EvaluatePose(compiled, Transform(), transforms); sink = transforms.back().position.x; });
+
+    // Picking over thousands of overlapping quads
+    traverse_canvas(tree.data, compiled, transforms, batch);
+    PickGrid::Grid pick_grid;
+    auto build_pick_grid = [&] {
+        pick_grid.Clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            Vec2 quad[4];
+            for (int k = 0; k < 4; ++k) quad[k] = Vec2(batch.cornerX[k][i], batch.cornerY[k][i]);
+            pick_grid.Add((int)i, quad, { batch.minX[i], batch.minY[i] }, { batch.maxX[i], batch.maxY[i] });
+        }
+        pick_grid.Build();
+    };
+    runner.Add("canvas.pick_grid.build.tree5000", batch.size(), build_pick_grid);
+    build_pick_grid();
+    std::vector<Vec2> pick_points;
+    for (size_t i = 0; i < batch.size(); i += 5) pick_points.push_back({ batch.centerX[i] + 3.0f, batch.centerY[i] - 2.0f });
+    runner.Add("canvas.pick.tree5000", pick_points.size(), [&] {
+        int hits = 0;
+        for (const Vec2& point : pick_points) hits += pick_grid.Pick(point) >= 0;
+        sink = (float)hits;
+    });
+
+    // Export and parsing, on files the exporter wrote
+    std::string success, error;
+    const std::filesystem::path export_path = work_dir / "export.lua";
+    runner.Add("export.save.tree5000", tree.nodeCount, [&] { Export::SaveToFile(export_path.string(), tree.data.root.get(), tree.data.sprites, success, error); });
+    SyntheticRig parse_rig;
+    make_tree(parse_rig, 2000, 8, 8);
+    const std::filesystem::path script_path = work_dir / "parse.lua";
+    Export::SaveToFile(script_path.string(), parse_rig.data.root.get(), parse_rig.data.sprites, success, error);
+    runner.Add("load.parse.tree2000", parse_rig.nodeCount, [&] {
+        SpriteData data;
+        std::string parse_error;
+        if (!parse_sprite_file(script_path.string(), {}, data, parse_error)) std::fprintf(stderr, "%s\n", parse_error.c_str());
+    });
+
+    // Decoding per format; the GL loader hands DDS to the GPU compressed
+    DecodedImage image = make_image(512, 512);
+    write_tga(work_dir / "raw.tga", 512, 512, false);
+    write_tga(work_dir / "rle.tga", 512, 512, true);
+    ImageDecoder::SavePNG(work_dir / "image.png", image, error);
+    for (const char* file : { "raw.tga", "rle.tga", "image.png" }) {
+        std::filesystem::path path = work_dir / file;
+        runner.Add(std::string("decode.") + file, 512 * 512, [&] {
+            DecodedImage decoded;
+            std::string decode_error;
+            ImageDecoder::DecodeUncached(path, decoded, decode_error);
+        });
+    }
+    runner.Add("decode.cache_hit.png", 512 * 512, [&] {
+        DecodedImage decoded;
+        std::string decode_error;
+        ImageDecoder::Decode(work_dir / "image.png", decoded, decode_error);
+    });
+
+    const std::vector<Result>& results = runner.Results();
+    if (!json_path.empty() && !write_json(json_path, results)) {
+        std::fprintf(stderr, "Could not write %s\n", json_path.c_str());
+        return 2;
+    }
+    if (baseline_path.empty()) return 0;
+
+    std::map<std::string, double> baseline;
+    if (!read_baseline(baseline_path, baseline)) {
+        std::fprintf(stderr, "Could not read baseline %s\n", baseline_path.c_str());
+        return 2;
+    }
+    int regressions = 0;
+    std::printf("\nAgainst %s (tolerance %.1f%%):\n", baseline_path.c_str(), tolerance);
+    for (const Result& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::printf("%-34s      new\n", r.name.c_str());
+            continue;
+        }
+        const double change = (r.medianNs / it->second - 1.0) * 100.0;
+        const bool regressed = change > tolerance;
+        regressions += regressed;
+        std::printf("%-34s %+8.1f%%%s\n", r.name.c_str(), change, regressed ? "  REGRESSION" : "");
+    }
+    return regressions == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+    // Microbenchmarks of the hot paths on synthetic rigs:
+    // PivotHelper --benchmark [--filter <text>] [--json <file>] [--baseline <file>] [--tolerance <percent>]
+    // Results can be written as JSON and compared against an earlier run;
+    // the exit code is 1 when any median regresses past the tolerance.
+    int Run(const std::vector<std::string>& args);
+}
\ No newline at end of file
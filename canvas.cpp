@@ -1,79 +1,177 @@
 #include "canvas.h"
 #include "pivot_logic.h"
+#include "quad_batch.h"
+#include "pick_grid.h"
+#include "alpha_mask.h"
+#include "texture_upload.h"
+#include "profiler.h"
 #include <imgui.h>
 #include <algorithm>
+#include <cmath>
 #include <vector>
-
-#ifndef IM_PI
-#define IM_PI           3.14159265358979323846f
-#endif
+#include <utility>
 
 namespace {
-    struct SimpleRect { ImVec2 Min, Max; SimpleRect(const ImVec2& min, const ImVec2& max) : Min(min), Max(max) {} bool Contains(const ImVec2& p) const { return p.x >= Min.x && p.y >= Min.y && p.x < Max.x && p.y < Max.y; } };
-    struct RenderInfo { Node* node = nullptr; SimpleRect bounds = SimpleRect({ 0,0 }, { 0,0 }); Transform transform; };
-
-    ImVec2 rotate_point(const ImVec2& point, const ImVec2& center, float angle_rad) {
-        float s = sin(angle_rad); float c = cos(angle_rad);
-        ImVec2 p = ImVec2(point.x - center.x, point.y - center.y);
-        return ImVec2(center.x + (p.x * c - p.y * s), center.y + (p.x * s + p.y * c));
-    }
+    struct SimpleRect { Vec2 Min, Max; SimpleRect(const Vec2& min, const Vec2& max) : Min(min), Max(max) {} };
+    // quad is the whole texture; opaque and bounds cover only its trimmed
+    // opaque rect, and empty marks a fully transparent texture.
+    struct RenderInfo { Node* node = nullptr; SimpleRect bounds = SimpleRect({ 0,0 }, { 0,0 }); Transform transform; Vec2 quad[4]; Vec2 opaque[4]; bool empty = false; };
 
-    void draw_and_collect_bounds(Node* node, const Transform& parent_transform, const SpriteFrame* parent_frame, const CanvasState& canvas, std::vector<RenderInfo>& out_render_info, const std::string& activeState, const std::string& defaultState, int activeFrame) {
-        if (!node) return;
+    ImVec2 to_screen(const Affine2D& view, const Vec2& p) { Vec2 q = PivotLogic::TransformPoint(view, p); return ImVec2(q.x, q.y); }
 
-        Transform my_transform = PivotLogic::CalculateWorldTransform(node, parent_transform, parent_frame, canvas);
+    // The point of the quad at texture coordinates (s, t) in [0, 1].
+    Vec2 quad_point(const Vec2 quad[4], float s, float t) {
+        return { quad[0].x + (quad[1].x - quad[0].x) * s + (quad[3].x - quad[0].x) * t, quad[0].y + (quad[1].y - quad[0].y) * s + (quad[3].y - quad[0].y) * t };
+    }
 
-        const SpriteFrame* frame_for_child = nullptr;
-        if (node->sprite_ptr && node->sprite_ptr->states.count(defaultState) && !node->sprite_ptr->states.at(defaultState).frames.empty()) {
-            frame_for_child = &node->sprite_ptr->states.at(defaultState).frames[0];
+    void trim_to_opaque(RenderInfo& info, const AlphaMask::Mask* mask) {
+        info.empty = mask && mask->Empty();
+        if (!mask || info.empty || mask->width <= 0 || mask->height <= 0) {
+            for (int k = 0; k < 4; ++k) info.opaque[k] = info.quad[k];
+            return;
         }
-        for (const auto& child : node->childrenBehind) {
-            draw_and_collect_bounds(child.get(), my_transform, frame_for_child, canvas, out_render_info, activeState, defaultState, activeFrame);
+        const float s0 = (float)mask->trimMinX / mask->width, s1 = (float)mask->trimMaxX / mask->width;
+        const float t0 = (float)mask->trimMinY / mask->height, t1 = (float)mask->trimMaxY / mask->height;
+        info.opaque[0] = quad_point(info.quad, s0, t0);
+        info.opaque[1] = quad_point(info.quad, s1, t0);
+        info.opaque[2] = quad_point(info.quad, s1, t1);
+        info.opaque[3] = quad_point(info.quad, s0, t1);
+        Vec2 min = info.opaque[0], max = info.opaque[0];
+        for (int k = 1; k < 4; ++k) {
+            min = { std::min(min.x, info.opaque[k].x), std::min(min.y, info.opaque[k].y) };
+            max = { std::max(max.x, info.opaque[k].x), std::max(max.y, info.opaque[k].y) };
         }
+        info.bounds = SimpleRect(min, max);
+    }
 
-        if (!node->sprite_ptr || node->sprite_ptr->states.empty()) {
-            for (const auto& child : node->childrenInFront) {
-                draw_and_collect_bounds(child.get(), my_transform, nullptr, canvas, out_render_info, activeState, defaultState, activeFrame);
-            }
-            return;
-        }
+    // Maps the rig-space point back into the texture and tests its texel.
+    bool hits_opaque_texel(const RenderInfo& info, const SpriteFrame& frame, const Vec2& point) {
+        const AlphaMask::Mask* mask = frame.alphaMask.get();
+        if (!mask) return true;
+        const Vec2 u = { info.quad[1].x - info.quad[0].x, info.quad[1].y - info.quad[0].y };
+        const Vec2 v = { info.quad[3].x - info.quad[0].x, info.quad[3].y - info.quad[0].y };
+        const float det = u.x * v.y - u.y * v.x;
+        if (std::fabs(det) < 1e-12f) return false;
+        const Vec2 d = { point.x - info.quad[0].x, point.y - info.quad[0].y };
+        const float s = (d.x * v.y - d.y * v.x) / det;
+        const float t = (u.x * d.y - u.y * d.x) / det;
+        return mask->Test((int)std::floor(s * mask->width), (int)std::floor(t * mask->height));
+    }
 
-        auto state_it = node->sprite_ptr->states.find(activeState);
-        bool useEffectiveState = (state_it != node->sprite_ptr->states.end() && !state_it->second.isLink);
-        if (!useEffectiveState) {
-            state_it = node->sprite_ptr->states.find(defaultState);
+    // Rig-space pose cache indexed by rig index. It is rebuilt when the rig or
+    // the active state/frame changes and property edits only refresh the edited
+    // subtrees; pan and zoom never touch it. The pick grid follows every pose
+    // change.
+    struct PoseCache {
+        PivotLogic::CompiledRig rig;
+        std::vector<Transform> transforms;
+        std::vector<RenderInfo> renderInfos;
+        std::vector<std::pair<int, int>> dirtyRanges;
+        std::vector<int> batchIndices;
+        QuadBatch::Batch batch;
+        PickGrid::Grid pickGrid;
+        const SpriteData* spriteData = nullptr;
+        const Node* root = nullptr;
+        std::string activeState;
+        int activeFrame = -1;
+    };
+    PoseCache g_pose;
+
+    void collect_bounds(PoseCache& pose, int begin, int end) {
+        const PivotLogic::CompiledRig& rig = pose.rig;
+        pose.batchIndices.clear();
+        for (int index = begin; index < end; ++index) {
+            if (rig.drawFrame[index]) pose.batchIndices.push_back(index);
         }
-        if (state_it == node->sprite_ptr->states.end() || state_it->second.frames.empty()) return;
-
-        const auto& frames = state_it->second.frames;
-        int frameIndex = useEffectiveState ? std::min((int)frames.size() - 1, activeFrame) : 0;
-        const SpriteFrame& my_frame = frames[frameIndex];
 
-        if (my_frame.textureId == 0) return;
+        QuadBatch::Batch& batch = pose.batch;
+        batch.Resize(pose.batchIndices.size());
+        for (size_t i = 0; i < pose.batchIndices.size(); ++i) {
+            int index = pose.batchIndices[i];
+            const SpriteFrame& my_frame = *rig.drawFrame[index];
+            const Transform& my_transform = pose.transforms[index];
+            batch.centerX[i] = my_transform.position.x;
+            batch.centerY[i] = my_transform.position.y;
+            batch.halfWidth[i] = my_frame.width * 0.5f;
+            batch.halfHeight[i] = my_frame.height * 0.5f;
+            batch.axisXx[i] = my_transform.matrix.a;
+            batch.axisXy[i] = my_transform.matrix.b;
+            batch.axisYx[i] = my_transform.matrix.c;
+            batch.axisYy[i] = my_transform.matrix.d;
+        }
+        QuadBatch::Compute(batch);
+
+        for (size_t i = 0; i < pose.batchIndices.size(); ++i) {
+            int index = pose.batchIndices[i];
+            RenderInfo& info = pose.renderInfos[index];
+            for (int k = 0; k < 4; ++k) info.quad[k] = Vec2(batch.cornerX[k][i], batch.cornerY[k][i]);
+            info.node = rig.nodes[index];
+            info.bounds = SimpleRect({ batch.minX[i], batch.minY[i] }, { batch.maxX[i], batch.maxY[i] });
+            info.transform = pose.transforms[index];
+            trim_to_opaque(info, rig.drawFrame[index]->alphaMask.get());
+        }
+    }
 
-        float angle_rad = my_transform.angle_deg * IM_PI / 180.0f;
-        float width_half = my_frame.width * 0.5f * canvas.zoom;
-        float height_half = my_frame.height * 0.5f * canvas.zoom;
+    void rebuild_pick_grid(PoseCache& pose) {
+        pose.pickGrid.Clear();
+        for (int index : pose.rig.drawOrder) {
+            const RenderInfo& info = pose.renderInfos[index];
+            if (!info.empty) pose.pickGrid.Add(index, info.opaque, info.bounds.Min, info.bounds.Max);
+        }
+        pose.pickGrid.Build();
+    }
 
-        ImVec2 p1 = rotate_point({ my_transform.position.x - width_half, my_transform.position.y - height_half }, my_transform.position, angle_rad);
-        ImVec2 p2 = rotate_point({ my_transform.position.x + width_half, my_transform.position.y - height_half }, my_transform.position, angle_rad);
-        ImVec2 p3 = rotate_point({ my_transform.position.x + width_half, my_transform.position.y + height_half }, my_transform.position, angle_rad);
-        ImVec2 p4 = rotate_point({ my_transform.position.x - width_half, my_transform.position.y + height_half }, my_transform.position, angle_rad);
+    void update_pose(SpriteData* spriteData, Node* root, const std::string& activeState, int activeFrame) {
+        PoseCache& pose = g_pose;
+        const Transform root_transform;
+        bool recompile = spriteData->rigDirty || pose.spriteData != spriteData || pose.root != root || pose.activeState != activeState || pose.activeFrame != activeFrame;
+
+        pose.dirtyRanges.clear();
+        if (recompile) {
+            PivotLogic::CompileRig(root, activeState, spriteData->defaultState, activeFrame, pose.rig);
+            pose.renderInfos.resize(pose.rig.size());
+            Profiler::AddCount(Profiler::Counter::NodesTraversed, (int)pose.rig.size());
+            spriteData->rigDirty = false;
+            spriteData->dirtyNodes.clear();
+            spriteData->dirtySprites.clear();
+            pose.spriteData = spriteData;
+            pose.root = root;
+            pose.activeState = activeState;
+            pose.activeFrame = activeFrame;
+        }
+        else if (!spriteData->dirtyNodes.empty() || !spriteData->dirtySprites.empty()) {
+            PivotLogic::SyncDirtyNodes(pose.rig, *spriteData, pose.dirtyRanges);
+        }
 
-        ImGui::GetWindowDrawList()->AddImageQuad((ImTextureID)(intptr_t)my_frame.textureId, p1, p2, p3, p4);
+        if (recompile) {
+            PivotLogic::EvaluatePose(pose.rig, root_transform, pose.transforms);
+            collect_bounds(pose, 0, (int)pose.rig.size());
+            rebuild_pick_grid(pose);
+            return;
+        }
 
-        float minX = std::min({ p1.x, p2.x, p3.x, p4.x }); float minY = std::min({ p1.y, p2.y, p3.y, p4.y });
-        float maxX = std::max({ p1.x, p2.x, p3.x, p4.x }); float maxY = std::max({ p1.y, p2.y, p3.y, p4.y });
+        for (const auto& range : pose.dirtyRanges) {
+            Profiler::AddCount(Profiler::Counter::NodesTraversed, range.second - range.first);
+            PivotLogic::EvaluatePoseRange(pose.rig, root_transform, range.first, range.second, pose.transforms);
+            collect_bounds(pose, range.first, range.second);
+        }
+        if (!pose.dirtyRanges.empty()) rebuild_pick_grid(pose);
+    }
 
-        out_render_info.push_back({ node, SimpleRect({minX, minY}, {maxX, maxY}), my_transform });
+    const RenderInfo* find_render_info(const Node* node) {
+        if (!node) return nullptr;
+        int index = node->rigIndex;
+        if (index < 0 || index >= (int)g_pose.rig.size() || g_pose.rig.nodes[index] != node || !g_pose.rig.drawFrame[index]) return nullptr;
+        return &g_pose.renderInfos[index];
+    }
 
-        for (const auto& child : node->childrenInFront) {
-            draw_and_collect_bounds(child.get(), my_transform, &my_frame, canvas, out_render_info, activeState, defaultState, activeFrame);
-        }
+    void draw_outline(ImDrawList* draw_list, const Affine2D& view, const RenderInfo& info, ImU32 color, float thickness) {
+        const Vec2* quad = info.empty ? info.quad : info.opaque;
+        draw_list->AddQuad(to_screen(view, quad[0]), to_screen(view, quad[1]), to_screen(view, quad[2]), to_screen(view, quad[3]), color, thickness);
     }
 }
 
-void Canvas::Render(Node* root, CanvasState& canvas, Node*& selectedNode, bool showPivots, const std::string& activeState, const std::string& defaultState, int activeFrame) {
+void Canvas::Render(SpriteData* spriteData, CanvasState& canvas, Node*& selectedNode, bool showPivots, const std::string& activeState, int activeFrame) {
     ImGuiIO& io = ImGui::GetIO();
     bool isWindowHovered = ImGui::IsWindowHovered();
 
@@ -81,38 +179,76 @@ void Canvas::Render(Node* root, CanvasState& canvas, Node*& selectedNode, bool s
         if (io.MouseWheel != 0.0f) { canvas.zoom *= powf(1.1f, io.MouseWheel); canvas.zoom = std::max(0.05f, std::min(canvas.zoom, 20.0f)); }
         if (ImGui::IsMouseDragging(ImGuiMouseButton_Right) || ImGui::IsMouseDragging(ImGuiMouseButton_Middle)) { canvas.pan.x += io.MouseDelta.x; canvas.pan.y += io.MouseDelta.y; }
     }
+    Node* root = spriteData ? spriteData->root.get() : nullptr;
     if (!root) return;
 
     ImVec2 window_pos = ImGui::GetWindowPos();
     ImVec2 canvas_min = ImGui::GetWindowContentRegionMin(); ImVec2 canvas_max = ImGui::GetWindowContentRegionMax();
     ImVec2 canvas_center = { window_pos.x + canvas_min.x + (canvas_max.x - canvas_min.x) * 0.5f, window_pos.y + canvas_min.y + (canvas_max.y - canvas_min.y) * 0.5f };
-    Transform root_transform = { {canvas_center.x + canvas.pan.x, canvas_center.y + canvas.pan.y}, 0.0f };
-    root_transform.anchor_pos = root_transform.position;
-
-    std::vector<RenderInfo> render_infos;
-    draw_and_collect_bounds(root, root_transform, nullptr, canvas, render_infos, activeState, defaultState, activeFrame);
-
-    if (isWindowHovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-        Node* newSelectedNode = nullptr;
-        for (int i = render_infos.size() - 1; i >= 0; --i) {
-            if (render_infos[i].bounds.Contains(io.MousePos)) {
-                newSelectedNode = render_infos[i].node;
-                break;
-            }
+    const Affine2D view = PivotLogic::MakeViewMatrix({ canvas_center.x + canvas.pan.x, canvas_center.y + canvas.pan.y }, canvas.zoom);
+
+    update_pose(spriteData, root, activeState, activeFrame);
+
+    const PivotLogic::CompiledRig& rig = g_pose.rig;
+    const std::vector<RenderInfo>& render_infos = g_pose.renderInfos;
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    const int first_command = draw_list->CmdBuffer.Size;
+    Profiler::BeginGpuCanvas(draw_list);
+
+    // Quads whose opaque part is off screen are skipped.
+    const Vec2 visible_min = { (window_pos.x + canvas_min.x - view.tx) / view.a, (window_pos.y + canvas_min.y - view.ty) / view.d };
+    const Vec2 visible_max = { (window_pos.x + canvas_max.x - view.tx) / view.a, (window_pos.y + canvas_max.y - view.ty) / view.d };
+    int emitted = 0;
+    for (int index : rig.drawOrder) {
+        const RenderInfo& info = render_infos[index];
+        if (info.empty || info.bounds.Max.x < visible_min.x || info.bounds.Min.x > visible_max.x || info.bounds.Max.y < visible_min.y || info.bounds.Min.y > visible_max.y) continue;
+        ++emitted;
+        const SpriteFrame& frame = *rig.drawFrame[index];
+        ImVec2 p0 = to_screen(view, info.quad[0]), p1 = to_screen(view, info.quad[1]);
+        ImVec2 p2 = to_screen(view, info.quad[2]), p3 = to_screen(view, info.quad[3]);
+        if (TextureUpload::IsPending((GLuint)frame.textureId)) {
+            draw_list->AddQuadFilled(p0, p1, p2, p3, IM_COL32(80, 80, 80, 160));
+            draw_list->AddQuad(p0, p1, p2, p3, IM_COL32(140, 140, 140, 255));
+            continue;
         }
-        selectedNode = newSelectedNode;
+        draw_list->AddImageQuad((ImTextureID)frame.textureId, p0, p1, p2, p3,
+            ImVec2(frame.uvMin.x, frame.uvMin.y), ImVec2(frame.uvMax.x, frame.uvMin.y), ImVec2(frame.uvMax.x, frame.uvMax.y), ImVec2(frame.uvMin.x, frame.uvMax.y));
     }
+    Profiler::AddCount(Profiler::Counter::QuadsEmitted, emitted);
+
+    // Picking tests the rotated opaque rects and then the texel under the
+    // cursor, so the part visibly drawn there wins.
+    int hovered = -1;
+    if (isWindowHovered) {
+        Vec2 mouse_rig = { (io.MousePos.x - view.tx) / view.a, (io.MousePos.y - view.ty) / view.d };
+        hovered = g_pose.pickGrid.Pick(mouse_rig, [&](int index) { return hits_opaque_texel(render_infos[index], *rig.drawFrame[index], mouse_rig); });
+        if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) selectedNode = hovered >= 0 ? rig.nodes[hovered] : nullptr;
+    }
+
+    if (hovered >= 0 && rig.nodes[hovered] != selectedNode) {
+        draw_outline(draw_list, view, render_infos[hovered], IM_COL32(255, 255, 255, 140), 1.0f);
+    }
+    if (const RenderInfo* info = find_render_info(selectedNode)) {
+        draw_outline(draw_list, view, *info, IM_COL32(255, 255, 0, 255), 1.5f);
+        if (showPivots) {
+            ImVec2 anchor = to_screen(view, info->transform.anchor_pos);
+            draw_list->AddCircleFilled(anchor, 4.0f, IM_COL32(255, 0, 255, 255));
+            draw_list->AddCircle(anchor, 4.0f, IM_COL32(0, 0, 0, 255));
+        }
+    }
+
+    Profiler::EndGpuCanvas(draw_list);
 
-    if (selectedNode) {
-        for (const auto& info : render_infos) {
-            if (info.node == selectedNode) {
-                ImGui::GetWindowDrawList()->AddRect(info.bounds.Min, info.bounds.Max, IM_COL32(255, 255, 0, 255), 0.0f, 0, 1.5f);
-                if (showPivots) {
-                    ImGui::GetWindowDrawList()->AddCircleFilled(info.transform.anchor_pos, 4.0f, IM_COL32(255, 0, 255, 255));
-                    ImGui::GetWindowDrawList()->AddCircle(info.transform.anchor_pos, 4.0f, IM_COL32(0, 0, 0, 255));
-                }
-                break;
-            }
+    if (Profiler::IsEnabled()) {
+        int commands = 0, binds = 0;
+        ImTextureID bound = nullptr;
+        for (int i = first_command; i < draw_list->CmdBuffer.Size; ++i) {
+            const ImDrawCmd& command = draw_list->CmdBuffer[i];
+            if (command.UserCallback || command.ElemCount == 0) continue;
+            ++commands;
+            if (command.TextureId != bound) { bound = command.TextureId; ++binds; }
         }
+        Profiler::AddCount(Profiler::Counter::DrawCommands, commands);
+        Profiler::AddCount(Profiler::Counter::TextureBinds, binds);
     }
 }
\ No newline at end of file
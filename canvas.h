@@ -3,5 +3,5 @@
 #include <string>
 
 namespace Canvas {
-    void Render(Node* root, CanvasState& canvas, Node*& selectedNode, bool showPivots, const std::string& activeState, const std::string& defaultState, int activeFrame);
+    void Render(SpriteData* spriteData, CanvasState& canvas, Node*& selectedNode, bool showPivots, const std::string& activeState, int activeFrame);
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "compositor.h"
+#include "environment.h"
+#include "file_handling.h"
+#include "pivot_logic.h"
+#include "quad_batch.h"
+#include "thread_pool.h"
+#include "vfs.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COMPOSITOR_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#define COMPOSITOR_TARGET_SSE2
+#else
+#define COMPOSITOR_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+namespace {
+    // The quad of one frame, mapped back from canvas pixels into texels.
+    struct Span {
+        const DecodedImage* texture;
+        float originU, originV;   // offset into the quad, in texels, at canvas pixel (0, 0)
+        float duDx, dvDx, duDy, dvDy;
+        float maxU, maxV;         // the quad covers [0, maxU) x [0, maxV) in texels
+        float baseU, baseV;       // texel position of the quad's top-left corner
+    };
+
+    void premultiply(DecodedImage& image) {
+        unsigned char* p = image.pixels.data();
+        for (size_t i = 0, n = (size_t)image.width * image.height; i < n; ++i, p += 4) {
+            unsigned a = p[3];
+            p[0] = (unsigned char)((p[0] * a + 127) / 255);
+            p[1] = (unsigned char)((p[1] * a + 127) / 255);
+            p[2] = (unsigned char)((p[2] * a + 127) / 255);
+        }
+    }
+
+    // Range of x in [lo, hi) where origin + slope * (x + 0.5) stays in [0, limit).
+    void clip_axis(float origin, float slope, float limit, float& lo, float& hi) {
+        const float at_center = origin + slope * 0.5f;
+        if (std::fabs(slope) < 1e-12f) {
+            if (at_center < 0.0f || at_center >= limit) hi = lo;
+            return;
+        }
+        float x0 = (0.0f - at_center) / slope, x1 = (limit - at_center) / slope;
+        if (x0 > x1) std::swap(x0, x1);
+        lo = std::max(lo, std::ceil(x0));
+        hi = std::min(hi, std::ceil(x1));
+    }
+
+    void texel_coords(const DecodedImage& texture, float u, float v, int& x0, int& y0, int& x1, int& y1, float& fx, float& fy) {
+        // Texel centers sit at +0.5; clamp to edge like the GL sampler.
+        float x = std::min(std::max(u - 0.5f, 0.0f), (float)(texture.width - 1));
+        float y = std::min(std::max(v - 0.5f, 0.0f), (float)(texture.height - 1));
+        x0 = (int)x; y0 = (int)y;
+        x1 = std::min(x0 + 1, texture.width - 1);
+        y1 = std::min(y0 + 1, texture.height - 1);
+        fx = x - x0; fy = y - y0;
+    }
+
+    void blend_row_scalar(const Span& span, float u, float v, float* dst, int count) {
+        const DecodedImage& texture = *span.texture;
+        const unsigned char* pixels = texture.pixels.data();
+        const size_t stride = (size_t)texture.width * 4;
+        for (int i = 0; i < count; ++i, u += span.duDx, v += span.dvDx, dst += 4) {
+            int x0, y0, x1, y1; float fx, fy;
+            texel_coords(texture, u, v, x0, y0, x1, y1, fx, fy);
+            const unsigned char* t00 = pixels + y0 * stride + x0 * 4; const unsigned char* t10 = pixels + y0 * stride + x1 * 4;
+            const unsigned char* t01 = pixels + y1 * stride + x0 * 4; const unsigned char* t11 = pixels + y1 * stride + x1 * 4;
+            float w00 = (1 - fx) * (1 - fy) / 255.0f, w10 = fx * (1 - fy) / 255.0f, w01 = (1 - fx) * fy / 255.0f, w11 = fx * fy / 255.0f;
+            float src[4];
+            for (int c = 0; c < 4; ++c) src[c] = t00[c] * w00 + t10[c] * w10 + t01[c] * w01 + t11[c] * w11;
+            float keep = 1.0f - src[3];
+            for (int c = 0; c < 4; ++c) dst[c] = src[c] + dst[c] * keep;
+        }
+    }
+
+#ifdef COMPOSITOR_X86
+    COMPOSITOR_TARGET_SSE2 inline __m128 load_texel(const unsigned char* p) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i bytes = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(p));
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    // One RGBA pixel per register: the four bilinear taps are weighted and
+    // blended "over" the premultiplied canvas in a handful of vector ops.
+    COMPOSITOR_TARGET_SSE2 void blend_row_sse2(const Span& span, float u, float v, float* dst, int count) {
+        const DecodedImage& texture = *span.texture;
+        const unsigned char* pixels = texture.pixels.data();
+        const size_t stride = (size_t)texture.width * 4;
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+        for (int i = 0; i < count; ++i, u += span.duDx, v += span.dvDx, dst += 4) {
+            int x0, y0, x1, y1; float fx, fy;
+            texel_coords(texture, u, v, x0, y0, x1, y1, fx, fy);
+            __m128 wx = _mm_set1_ps(fx), wy = _mm_set1_ps(fy);
+            __m128 top = _mm_add_ps(load_texel(pixels + y0 * stride + x0 * 4), _mm_mul_ps(wx, _mm_sub_ps(load_texel(pixels + y0 * stride + x1 * 4), load_texel(pixels + y0 * stride + x0 * 4))));
+            __m128 bottom = _mm_add_ps(load_texel(pixels + y1 * stride + x0 * 4), _mm_mul_ps(wx, _mm_sub_ps(load_texel(pixels + y1 * stride + x1 * 4), load_texel(pixels + y1 * stride + x0 * 4))));
+            __m128 src = _mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(wy, _mm_sub_ps(bottom, top))), inv255);
+            __m128 keep = _mm_sub_ps(one, _mm_shuffle_ps(src, src, _MM_SHUFFLE(3, 3, 3, 3)));
+            _mm_storeu_ps(dst, _mm_add_ps(src, _mm_mul_ps(_mm_loadu_ps(dst), keep)));
+        }
+    }
+#endif
+
+    // Rows [rowBegin, rowEnd) must cover the quad's bounding box; clip_axis
+    // finds the exact columns within each row.
+    void draw_span(const Span& span, std::vector<float>& canvas, int width, int rowBegin, int rowEnd) {
+        if (span.texture->pixels.empty()) return;
+#ifdef COMPOSITOR_X86
+        const bool use_sse2 = QuadBatch::ActiveBackend() != QuadBatch::Backend::Scalar;
+#endif
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const float row_u = span.originU + span.duDy * (y + 0.5f);
+            const float row_v = span.originV + span.dvDy * (y + 0.5f);
+            float lo = 0.0f, hi = (float)width;
+            clip_axis(row_u, span.duDx, span.maxU, lo, hi);
+            clip_axis(row_v, span.dvDx, span.maxV, lo, hi);
+            if (hi <= lo) continue;
+            const int x = (int)lo, count = (int)hi - x;
+            const float u = span.baseU + row_u + span.duDx * (x + 0.5f), v = span.baseV + row_v + span.dvDx * (x + 0.5f);
+            float* dst = canvas.data() + ((size_t)y * width + x) * 4;
+#ifdef COMPOSITOR_X86
+            if (use_sse2) { blend_row_sse2(span, u, v, dst, count); continue; }
+#endif
+            blend_row_scalar(span, u, v, dst, count);
+        }
+    }
+
+    void print_usage() {
+        std::printf(
+            "Usage: PivotHelper --render <script> [options]\n"
+            "  --state <name>       state to pose (default: Normal)\n"
+            "  --frame <n>          frame index (default: 0)\n"
+            "  --frames <a>-<b>     render every frame in the range\n"
+            "  --scale <factor>     output pixels per texture pixel (default: 1)\n"
+            "  --size <w>x<h>       fixed canvas with the rig origin centered\n"
+            "  --out <file.png>     output file; ranges append _<frame> (default: render.png)\n");
+    }
+}
+
+bool Compositor::LoadTextures(SpriteData& spriteData, const std::vector<std::string>& searchPaths, TextureSet& textures, std::string& errorMessage) {
+    std::map<std::string, size_t> slots;
+    std::vector<std::string> paths;
+    for (auto& [sprite_name, sprite] : spriteData.sprites) {
+        for (auto& [state_name, state] : sprite.states) {
+            for (auto& frame : state.frames) {
+                if (slots.emplace(frame.texturePath, paths.size()).second) paths.push_back(frame.texturePath);
+            }
+        }
+    }
+
+    textures.images.assign(paths.size(), DecodedImage());
+    std::vector<std::string> found_paths(paths.size()), errors(paths.size());
+    ThreadPool::ParallelFor(paths.size(), [&](size_t i) {
+        std::filesystem::path found_path = Vfs::Resolve(paths[i], searchPaths, SUPPORTED_IMAGE_EXTENSIONS);
+        if (found_path.empty()) {
+            errors[i] = "Image not found: " + paths[i];
+            return;
+        }
+        if (!ImageDecoder::Decode(found_path, textures.images[i], errors[i])) return;
+        premultiply(textures.images[i]);
+        found_paths[i] = found_path.string();
+    });
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!errors[i].empty()) {
+            errorMessage = errors[i];
+            return false;
+        }
+        spriteData.texturePaths[paths[i]] = found_paths[i];
+    }
+
+    for (auto& [sprite_name, sprite] : spriteData.sprites) {
+        for (auto& [state_name, state] : sprite.states) {
+            for (auto& frame : state.frames) {
+                size_t slot = slots[frame.texturePath];
+                frame.textureId = (TextureHandle)(slot + 1);
+                frame.width = textures.images[slot].width;
+                frame.height = textures.images[slot].height;
+                frame.uvMin = { 0.0f, 0.0f };
+                frame.uvMax = { 1.0f, 1.0f };
+            }
+        }
+    }
+    PivotLogic::MarkRigDirty(&spriteData);
+    return true;
+}
+
+void Compositor::Render(SpriteData& spriteData, const std::string& state, int frame, const TextureSet& textures, const RenderOptions& options, DecodedImage& out) {
+    PivotLogic::CompiledRig rig;
+    std::vector<Transform> transforms;
+    PivotLogic::CompileRig(spriteData.root.get(), state, spriteData.defaultState, frame, rig);
+    PivotLogic::EvaluatePose(rig, Transform(), transforms);
+
+    QuadBatch::Batch batch;
+    batch.Resize(rig.drawOrder.size());
+    for (size_t i = 0; i < rig.drawOrder.size(); ++i) {
+        const int index = rig.drawOrder[i];
+        const SpriteFrame& my_frame = *rig.drawFrame[index];
+        const Transform& my_transform = transforms[index];
+        batch.centerX[i] = my_transform.position.x;
+        batch.centerY[i] = my_transform.position.y;
+        batch.halfWidth[i] = my_frame.width * 0.5f;
+        batch.halfHeight[i] = my_frame.height * 0.5f;
+        batch.axisXx[i] = my_transform.matrix.a;
+        batch.axisXy[i] = my_transform.matrix.b;
+        batch.axisYx[i] = my_transform.matrix.c;
+        batch.axisYy[i] = my_transform.matrix.d;
+    }
+    QuadBatch::Compute(batch);
+
+    // Canvas pixel p maps to rig point (p - origin) / scale.
+    const float scale = options.scale > 0.0f ? options.scale : 1.0f;
+    float origin_x, origin_y;
+    int width = options.width, height = options.height;
+    if (width > 0 && height > 0) {
+        origin_x = width * 0.5f;
+        origin_y = height * 0.5f;
+    }
+    else if (batch.size() == 0) {
+        width = height = 1;
+        origin_x = origin_y = 0.0f;
+    }
+    else {
+        float min_x = *std::min_element(batch.minX.begin(), batch.minX.end()), max_x = *std::max_element(batch.maxX.begin(), batch.maxX.end());
+        float min_y = *std::min_element(batch.minY.begin(), batch.minY.end()), max_y = *std::max_element(batch.maxY.begin(), batch.maxY.end());
+        origin_x = -std::floor(min_x * scale);
+        origin_y = -std::floor(min_y * scale);
+        width = std::max(1, (int)std::ceil(max_x * scale) + (int)origin_x);
+        height = std::max(1, (int)std::ceil(max_y * scale) + (int)origin_y);
+    }
+
+    std::vector<float> canvas((size_t)width * height * 4, 0.0f);
+    for (size_t i = 0; i < rig.drawOrder.size(); ++i) {
+        const SpriteFrame& my_frame = *rig.drawFrame[rig.drawOrder[i]];
+        if (my_frame.textureId == 0 || my_frame.textureId > textures.images.size()) continue;
+        const DecodedImage& texture = textures.images[my_frame.textureId - 1];
+        const float det = batch.axisXx[i] * batch.axisYy[i] - batch.axisYx[i] * batch.axisXy[i];
+        if (std::fabs(det) < 1e-12f || my_frame.width <= 0 || my_frame.height <= 0) continue;
+
+        // Inverse of the frame's linear part, with frame pixels scaled to the
+        // texel rectangle its UVs select.
+        const float texels_x = (my_frame.uvMax.x - my_frame.uvMin.x) * texture.width / my_frame.width;
+        const float texels_y = (my_frame.uvMax.y - my_frame.uvMin.y) * texture.height / my_frame.height;
+        const float inv_a = batch.axisYy[i] / det, inv_c = -batch.axisYx[i] / det;
+        const float inv_b = -batch.axisXy[i] / det, inv_d = batch.axisXx[i] / det;
+        // Corner 0 is the texture's top-left; local offsets are relative to it.
+        const float corner_x = batch.cornerX[0][i], corner_y = batch.cornerY[0][i];
+        const float rig_x0 = -origin_x / scale - corner_x, rig_y0 = -origin_y / scale - corner_y;
+
+        Span span;
+        span.texture = &texture;
+        span.duDx = inv_a / scale * texels_x;
+        span.dvDx = inv_b / scale * texels_y;
+        span.duDy = inv_c / scale * texels_x;
+        span.dvDy = inv_d / scale * texels_y;
+        span.originU = (inv_a * rig_x0 + inv_c * rig_y0) * texels_x;
+        span.originV = (inv_b * rig_x0 + inv_d * rig_y0) * texels_y;
+        span.baseU = my_frame.uvMin.x * texture.width;
+        span.baseV = my_frame.uvMin.y * texture.height;
+        span.maxU = my_frame.width * texels_x;
+        span.maxV = my_frame.height * texels_y;
+
+        // Pixel rows whose centers can fall inside the quad's rig-space bounds.
+        const float top = std::max(0.0f, std::floor(batch.minY[i] * scale + origin_y));
+        const float bottom = std::min((float)height, std::ceil(batch.maxY[i] * scale + origin_y));
+        if (bottom <= top) continue;
+        draw_span(span, canvas, width, (int)top, (int)bottom);
+    }
+
+    out.width = width;
+    out.height = height;
+    out.pixels.resize(canvas.size());
+    for (size_t p = 0; p < canvas.size(); p += 4) {
+        const float alpha = canvas[p + 3];
+        const float unpremultiply = alpha > 0.0f ? 255.0f / alpha : 0.0f;
+        for (int c = 0; c < 3; ++c) out.pixels[p + c] = (unsigned char)std::min(255.0f, canvas[p + c] * unpremultiply + 0.5f);
+        out.pixels[p + 3] = (unsigned char)std::min(255.0f, alpha * 255.0f + 0.5f);
+    }
+}
+
+int Compositor::Run(const std::vector<std::string>& args) {
+    std::string script, state = "Normal", out_file = "render.png";
+    int first_frame = 0, last_frame = -1;
+    RenderOptions options;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const bool has_value = i + 1 < args.size();
+        if (arg == "--state" && has_value) state = args[++i];
+        else if (arg == "--frame" && has_value) first_frame = std::max(0, std::atoi(args[++i].c_str()));
+        else if (arg == "--frames" && has_value) {
+            if (std::sscanf(args[++i].c_str(), "%d-%d", &first_frame, &last_frame) != 2 || first_frame < 0 || last_frame < first_frame) { print_usage(); return 2; }
+        }
+        else if (arg == "--scale" && has_value) options.scale = (float)std::atof(args[++i].c_str());
+        else if (arg == "--size" && has_value) {
+            if (std::sscanf(args[++i].c_str(), "%dx%d", &options.width, &options.height) != 2) { print_usage(); return 2; }
+        }
+        else if (arg == "--out" && has_value) out_file = args[++i];
+        else if (arg == "--help" || arg == "-h") { print_usage(); return 0; }
+        else if (script.empty() && arg[0] != '-') script = arg;
+        else { print_usage(); return 2; }
+    }
+    if (script.empty()) {
+        print_usage();
+        return 2;
+    }
+    if (last_frame < 0) last_frame = first_frame;
+
+    script = std::filesystem::absolute(script).lexically_normal().string();
+    std::vector<std::string> search_paths = Environment::SearchPathsForFile(script);
+    Vfs::IndexNow(search_paths);
+
+    SpriteData data;
+    TextureSet textures;
+    std::string errorMessage;
+    if (!parse_sprite_file(script, search_paths, data, errorMessage) || !LoadTextures(data, search_paths, textures, errorMessage)) {
+        std::fprintf(stderr, "%s\n", errorMessage.c_str());
+        return 1;
+    }
+
+    std::filesystem::path out_path(out_file);
+    DecodedImage image;
+    double render_ms = 0.0;
+    for (int frame = first_frame; frame <= last_frame; ++frame) {
+        auto start = std::chrono::steady_clock::now();
+        Render(data, state, frame, textures, options, image);
+        render_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::filesystem::path frame_path = out_path;
+        if (last_frame > first_frame) {
+            char suffix[16];
+            std::snprintf(suffix, sizeof(suffix), "_%04d", frame);
+            frame_path.replace_filename(out_path.stem().string() + suffix + out_path.extension().string());
+        }
+        if (!ImageDecoder::SavePNG(frame_path, image, errorMessage)) {
+            std::fprintf(stderr, "%s\n", errorMessage.c_str());
+            return 1;
+        }
+        std::printf("%s (%dx%d)\n", frame_path.string().c_str(), image.width, image.height);
+    }
+    const int frame_count = last_frame - first_frame + 1;
+    std::printf("Rendered %d frame(s) in %.2f ms (%.1f frames/s, %s blending)\n", frame_count, render_ms, frame_count * 1000.0 / std::max(render_ms, 1e-3),
+        QuadBatch::ActiveBackend() != QuadBatch::Backend::Scalar ? "SSE2" : "scalar");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include "datatypes.h"
+#include "image_decoder.h"
+#include <string>
+#include <vector>
+
+namespace Compositor {
+    // Decoded frame textures with premultiplied alpha. A frame's textureId is
+    // its 1-based index into images.
+    struct TextureSet {
+        std::vector<DecodedImage> images;
+    };
+
+    struct RenderOptions {
+        float scale = 1.0f;
+        // 0 fits the image to the pose; otherwise the rig origin is centered.
+        int width = 0;
+        int height = 0;
+    };
+
+    // Decodes every frame texture in parallel and points the frames at it,
+    // setting their sizes the way the GL loader does.
+    bool LoadTextures(SpriteData& spriteData, const std::vector<std::string>& searchPaths, TextureSet& textures, std::string& errorMessage);
+
+    // Poses the rig with the same pivot math as the canvas and rasterizes the
+    // frames in draw order with bilinear sampling into straight-alpha RGBA8.
+    void Render(SpriteData& spriteData, const std::string& state, int frame, const TextureSet& textures, const RenderOptions& options, DecodedImage& out);
+
+    // Headless rendering to PNG: PivotHelper --render <script> [options].
+    // Returns the process exit code.
+    int Run(const std::vector<std::string>& args);
+}
\ No newline at end of file
@@ -1,12 +1,12 @@
 #pragma once
 
-#include <GL/glew.h>
-#include <imgui.h>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
 #include <memory>
 #include <set>
+#include "name_index.h"
 
 const std::vector<std::string> SUPPORTED_IMAGE_EXTENSIONS = {
     ".dds",
@@ -15,24 +15,41 @@ const std::vector<std::string> SUPPORTED_IMAGE_EXTENSIONS = {
     ".jpg"
 };
 
-constexpr ImU32 COLOR_HIERARCHY_FRONT = IM_COL32(100, 255, 100, 255);
-constexpr ImU32 COLOR_HIERARCHY_BEHIND = IM_COL32(255, 180, 100, 255);
-constexpr ImVec4 BG_COLOR = ImVec4(0.113f, 0.113f, 0.113f, 1.00f);
-constexpr ImVec4 FRAME_BG_COLOR = ImVec4(0.188f, 0.188f, 0.188f, 1.00f);
-constexpr ImVec4 WIDGET_BG_COLOR = ImVec4(0.227f, 0.227f, 0.227f, 1.00f);
-constexpr ImVec4 TEXT_COLOR = ImVec4(0.878f, 0.878f, 0.878f, 1.00f);
+// The data model is free of GL and ImGui so it can be loaded and evaluated
+// headless; the renderer owns what a TextureHandle means (0 = none).
+using TextureHandle = std::uintptr_t;
+
+namespace AlphaMask { struct Mask; }
+
+struct Vec2 {
+    float x = 0.0f, y = 0.0f;
+    Vec2() = default;
+    Vec2(float x_, float y_) : x(x_), y(y_) {}
+};
+
+// Column-major 2x3 affine: x' = a*x + c*y + tx, y' = b*x + d*y + ty.
+struct Affine2D {
+    float a = 1.0f, b = 0.0f;
+    float c = 0.0f, d = 1.0f;
+    float tx = 0.0f, ty = 0.0f;
+};
 
 struct Transform {
-    ImVec2 position = { 0,0 };
+    Vec2 position = { 0,0 };
     float angle_deg = 0;
-    ImVec2 anchor_pos = { 0,0 };
+    Vec2 anchor_pos = { 0,0 };
+    Affine2D matrix;
 };
 
 struct SpriteFrame {
-    GLuint textureId = 0;
+    TextureHandle textureId = 0;
     int width = 0;
     int height = 0;
     std::string texturePath;
+    Vec2 uvMin = { 0.0f, 0.0f };
+    Vec2 uvMax = { 1.0f, 1.0f };
+    // Opaque texels of the texture, for picking; null until loaded and for DDS.
+    std::shared_ptr<const AlphaMask::Mask> alphaMask;
 };
 
 struct SpriteState {
@@ -44,23 +61,51 @@ struct SpriteState {
     std::string nextState;
 };
 
-struct Sprite { std::string name; std::map<std::string, SpriteState> states; };
+struct Sprite { std::string name; std::map<std::string, SpriteState> states; Names::Index stateNames; };
+
+// Generational reference to a node in SpriteData::nodeSlots. It resolves to
+// null once the node is deleted or the tree is replaced, so unlike a Node* it
+// is safe to keep across frames. Generation 0 is the null handle.
+struct NodeHandle {
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+    bool operator==(const NodeHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const NodeHandle& other) const { return !(*this == other); }
+};
 
 struct Node {
     std::string name, spriteName;
     const Sprite* sprite_ptr = nullptr;
     std::vector<std::unique_ptr<Node>> childrenBehind;
     std::vector<std::unique_ptr<Node>> childrenInFront;
-    ImVec2 pivot = { 0, 0 };
-    ImVec2 pivotOffset = { 0, 0 };
+    Vec2 pivot = { 0, 0 };
+    Vec2 pivotOffset = { 0, 0 };
     float angle = 0;
+    int rigIndex = -1;
+    // Kept by Hierarchy::Link and the Hierarchy edits.
+    Node* parent = nullptr;
+    bool behind = false; // in parent->childrenBehind rather than childrenInFront
+    std::uint32_t slot = 0; // 0 = not in a node table
 };
 
+struct NodeSlot { Node* node = nullptr; std::uint32_t generation = 1; };
+
 struct SpriteData {
+    std::string scriptPath;
+    std::string scriptFile;
     std::map<std::string, Sprite> sprites;
     std::unique_ptr<Node> root;
-    std::map<std::string, GLuint> loadedTextures;
+    std::vector<NodeSlot> nodeSlots; // slot 0 stays empty for the null handle
+    std::vector<std::uint32_t> freeSlots;
+    Names::Index nodeNames; // kept by Hierarchy
+    Names::Index spriteNames;
+    std::map<std::string, std::string> texturePaths; // frame texture path -> resolved file
+    std::map<std::string, int> textureRefs; // resolved file -> frames using it
     std::vector<std::string> allAvailableStates;
     std::string defaultState = "Normal";
+    bool rigDirty = true;
+    unsigned structureVersion = 0; // bumped with rigDirty; views cache derived lists against it
+    std::vector<Node*> dirtyNodes;
+    std::vector<const Sprite*> dirtySprites;
 };
-struct CanvasState { float zoom = 1.0f; ImVec2 pan = { 0.0f, 0.0f }; };
\ No newline at end of file
+struct CanvasState { float zoom = 1.0f; Vec2 pan = { 0.0f, 0.0f }; };
\ No newline at end of file
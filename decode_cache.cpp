@@ -0,0 +1,203 @@
+#include "decode_cache.h"
+#include "environment.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x43544850; // "PHTC"
+    constexpr uint32_t CACHE_VERSION = 1;
+    constexpr size_t PIXEL_ALIGNMENT = 16;
+
+    // The pixel block starts at pixelOffset, so a mapped file can be used
+    // without parsing anything past the header.
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint64_t contentHash;
+        uint32_t pathLength;
+        uint32_t pixelOffset;
+    };
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool hash_file(const std::filesystem::path& source, uint64_t& hash) {
+        std::ifstream file(source, std::ios::binary);
+        if (!file.is_open()) return false;
+        hash = 14695981039346656037ull;
+        char buffer[64 * 1024];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            hash = fnv1a(buffer, (size_t)file.gcount(), hash);
+        }
+        return true;
+    }
+
+    bool source_stamp(const std::filesystem::path& source, uint64_t& size, int64_t& mtime) {
+        std::error_code ec;
+        size = std::filesystem::file_size(source, ec);
+        if (ec) return false;
+        mtime = (int64_t)std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+        return !ec;
+    }
+
+    const std::filesystem::path& cache_directory() {
+        static const std::filesystem::path directory = Environment::CacheDirectory("textures");
+        return directory;
+    }
+
+    std::filesystem::path cache_file_for(const std::string& source_key) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.rgba", (unsigned long long)fnv1a(source_key.data(), source_key.size()));
+        return cache_directory() / name;
+    }
+
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+            m_file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (m_file == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+            m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!m_mapping) return;
+            m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (m_data) m_size = (size_t)size.QuadPart;
+#else
+            m_fd = open(path.c_str(), O_RDONLY);
+            if (m_fd < 0) return;
+            struct stat st;
+            if (fstat(m_fd, &st) != 0 || st.st_size == 0) return;
+            void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+            if (data == MAP_FAILED) return;
+            m_data = static_cast<const unsigned char*>(data);
+            m_size = (size_t)st.st_size;
+#endif
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (m_data) UnmapViewOfFile(m_data);
+            if (m_mapping) CloseHandle(m_mapping);
+            if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+            if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+            if (m_fd >= 0) close(m_fd);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const unsigned char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+
+    private:
+        const unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = NULL;
+#else
+        int m_fd = -1;
+#endif
+    };
+}
+
+bool DecodeCache::Load(const std::filesystem::path& source, int& width, int& height, std::vector<unsigned char>& pixels) {
+    uint64_t source_size;
+    int64_t source_mtime;
+    if (!source_stamp(source, source_size, source_mtime)) return false;
+
+    const std::string source_key = source.lexically_normal().string();
+    MappedFile file(cache_file_for(source_key));
+    if (!file.Data() || file.Size() < sizeof(CacheHeader)) return false;
+
+    CacheHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) return false;
+    if (header.sourceSize != source_size || header.sourceMtime != source_mtime) return false;
+    if (header.pathLength != source_key.size() || sizeof(CacheHeader) + header.pathLength > file.Size()) return false;
+    if (std::memcmp(file.Data() + sizeof(CacheHeader), source_key.data(), source_key.size()) != 0) return false;
+
+    const size_t pixel_bytes = (size_t)header.width * header.height * 4;
+    if (header.width == 0 || header.height == 0 || header.pixelOffset + pixel_bytes > file.Size()) return false;
+
+    if (Environment::GetDecodeCacheVerifyContent()) {
+        uint64_t content_hash;
+        if (!hash_file(source, content_hash) || content_hash != header.contentHash) return false;
+    }
+
+    width = (int)header.width;
+    height = (int)header.height;
+    const unsigned char* data = file.Data() + header.pixelOffset;
+    pixels.assign(data, data + pixel_bytes);
+    return true;
+}
+
+void DecodeCache::Store(const std::filesystem::path& source, int width, int height, const std::vector<unsigned char>& pixels) {
+    if (width <= 0 || height <= 0 || pixels.size() != (size_t)width * height * 4) return;
+
+    CacheHeader header = {};
+    if (!source_stamp(source, header.sourceSize, header.sourceMtime)) return;
+    if (Environment::GetDecodeCacheVerifyContent() && !hash_file(source, header.contentHash)) return;
+
+    const std::string source_key = source.lexically_normal().string();
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.pathLength = (uint32_t)source_key.size();
+    const size_t prefix = sizeof(CacheHeader) + source_key.size();
+    header.pixelOffset = (uint32_t)((prefix + PIXEL_ALIGNMENT - 1) / PIXEL_ALIGNMENT * PIXEL_ALIGNMENT);
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_directory(), ec);
+    const std::filesystem::path target = cache_file_for(source_key);
+
+    // Write next to the target and rename so readers never see a partial file.
+    std::ostringstream suffix;
+    suffix << ".tmp" << std::this_thread::get_id();
+    std::filesystem::path temp = target;
+    temp += suffix.str();
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return;
+        const char padding[PIXEL_ALIGNMENT] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(source_key.data(), source_key.size());
+        out.write(padding, header.pixelOffset - prefix);
+        out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) std::filesystem::remove(temp, ec);
+}
\ No newline at end of file
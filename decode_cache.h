@@ -0,0 +1,12 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+namespace DecodeCache {
+    // Decoded RGBA8 pixels (top row first) cached on disk under cache/textures
+    // next to the executable, one file per source path, validated against the
+    // source's size and mtime and optionally its content hash. Safe to call
+    // from worker threads.
+    bool Load(const std::filesystem::path& source, int& width, int& height, std::vector<unsigned char>& pixels);
+    void Store(const std::filesystem::path& source, int width, int height, const std::vector<unsigned char>& pixels);
+}
\ No newline at end of file
@@ -1,34 +1,14 @@
 #include "editor.h"
 #include "datatypes.h"
+#include "pivot_logic.h"
+#include "hierarchy.h"
+#include "theme.h"
 #include <imgui.h>
 #include <vector>
 #include <memory>
 #include <algorithm>
 
 namespace {
-    Node* FindParentOfNode(Node* searchRoot, Node* nodeToFind, std::vector<std::unique_ptr<Node>>*& childListRef, std::string& listNameRef) {
-        if (!searchRoot || !nodeToFind) return nullptr;
-        for (auto& child : searchRoot->childrenInFront) {
-            if (child.get() == nodeToFind) {
-                childListRef = &searchRoot->childrenInFront;
-                listNameRef = "ChildrenInFront";
-                return searchRoot;
-            }
-            Node* found = FindParentOfNode(child.get(), nodeToFind, childListRef, listNameRef);
-            if (found) return found;
-        }
-        for (auto& child : searchRoot->childrenBehind) {
-            if (child.get() == nodeToFind) {
-                childListRef = &searchRoot->childrenBehind;
-                listNameRef = "ChildrenBehind";
-                return searchRoot;
-            }
-            Node* found = FindParentOfNode(child.get(), nodeToFind, childListRef, listNameRef);
-            if (found) return found;
-        }
-        return nullptr;
-    }
-
     void DrawColorDot(ImU32 color) {
         ImVec2 p = ImGui::GetCursorScreenPos();
         ImGui::GetWindowDrawList()->AddCircleFilled(ImVec2(p.x + 8, p.y + ImGui::GetTextLineHeight() * 0.5f), 4.0f, color);
@@ -55,6 +35,7 @@ void Editor::Render(SpriteData* spriteData, Node*& selectedNode, bool& showPivot
         strncpy_s(nameBuffer, selectedNode->name.c_str(), sizeof(nameBuffer));
         ImGui::PushItemWidth(full_width);
         if (ImGui::InputText("##NodeName", nameBuffer, sizeof(nameBuffer))) {
+            if (spriteData) spriteData->nodeNames.Rename(selectedNode->name, nameBuffer);
             selectedNode->name = nameBuffer;
         }
         ImGui::PopItemWidth();
@@ -68,6 +49,7 @@ void Editor::Render(SpriteData* spriteData, Node*& selectedNode, bool& showPivot
             if (ImGui::Selectable("Set to Null", selectedNode->sprite_ptr == nullptr)) {
                 selectedNode->spriteName.clear();
                 selectedNode->sprite_ptr = nullptr;
+                PivotLogic::MarkRigDirty(spriteData);
             }
             ImGui::PopStyleColor();
             ImGui::Separator();
@@ -78,6 +60,7 @@ void Editor::Render(SpriteData* spriteData, Node*& selectedNode, bool& showPivot
                     if (ImGui::Selectable(name.c_str(), is_selected)) {
                         selectedNode->spriteName = name;
                         selectedNode->sprite_ptr = &sprite;
+                        PivotLogic::MarkRigDirty(spriteData);
                     }
                     if (is_selected) ImGui::SetItemDefaultFocus();
                 }
@@ -88,67 +71,67 @@ void Editor::Render(SpriteData* spriteData, Node*& selectedNode, bool& showPivot
 
         ImGui::Separator();
         ImGui::Text("Pivot");
+        bool poseChanged = false;
         ImGui::PushItemWidth(input_width);
-        ImGui::InputFloat("X##PivotX", &selectedNode->pivot.x, 0.0f, 0.0f, "%.4f");
+        poseChanged |= ImGui::InputFloat("X##PivotX", &selectedNode->pivot.x, 0.0f, 0.0f, "%.4f");
         ImGui::PopItemWidth(); ImGui::SameLine(0.0f, button_spacing);
         ImGui::PushButtonRepeat(true);
-        if (ImGui::Button("-##PivotX", ImVec2(button_width, 0))) { selectedNode->pivot.x -= 0.01f; }
+        if (ImGui::Button("-##PivotX", ImVec2(button_width, 0))) { selectedNode->pivot.x -= 0.01f; poseChanged = true; }
         ImGui::SameLine(0.0f, button_spacing);
-        if (ImGui::Button("+##PivotX", ImVec2(button_width, 0))) { selectedNode->pivot.x += 0.01f; }
+        if (ImGui::Button("+##PivotX", ImVec2(button_width, 0))) { selectedNode->pivot.x += 0.01f; poseChanged = true; }
         ImGui::PopButtonRepeat();
 
         ImGui::PushItemWidth(input_width);
-        ImGui::InputFloat("Y##PivotY", &selectedNode->pivot.y, 0.0f, 0.0f, "%.4f");
+        poseChanged |= ImGui::InputFloat("Y##PivotY", &selectedNode->pivot.y, 0.0f, 0.0f, "%.4f");
         ImGui::PopItemWidth(); ImGui::SameLine(0.0f, button_spacing);
         ImGui::PushButtonRepeat(true);
-        if (ImGui::Button("-##PivotY", ImVec2(button_width, 0))) { selectedNode->pivot.y -= 0.01f; }
+        if (ImGui::Button("-##PivotY", ImVec2(button_width, 0))) { selectedNode->pivot.y -= 0.01f; poseChanged = true; }
         ImGui::SameLine(0.0f, button_spacing);
-        if (ImGui::Button("+##PivotY", ImVec2(button_width, 0))) { selectedNode->pivot.y += 0.01f; }
+        if (ImGui::Button("+##PivotY", ImVec2(button_width, 0))) { selectedNode->pivot.y += 0.01f; poseChanged = true; }
         ImGui::PopButtonRepeat();
 
         ImGui::Separator();
         ImGui::Text("Pivot Offset");
         ImGui::PushItemWidth(input_width);
-        ImGui::InputFloat("X##OffsetX", &selectedNode->pivotOffset.x, 0.0f, 0.0f, "%.4f");
+        poseChanged |= ImGui::InputFloat("X##OffsetX", &selectedNode->pivotOffset.x, 0.0f, 0.0f, "%.4f");
         ImGui::PopItemWidth(); ImGui::SameLine(0.0f, button_spacing);
         ImGui::PushButtonRepeat(true);
-        if (ImGui::Button("-##OffsetX", ImVec2(button_width, 0))) { selectedNode->pivotOffset.x -= 0.01f; }
+        if (ImGui::Button("-##OffsetX", ImVec2(button_width, 0))) { selectedNode->pivotOffset.x -= 0.01f; poseChanged = true; }
         ImGui::SameLine(0.0f, button_spacing);
-        if (ImGui::Button("+##OffsetX", ImVec2(button_width, 0))) { selectedNode->pivotOffset.x += 0.01f; }
+        if (ImGui::Button("+##OffsetX", ImVec2(button_width, 0))) { selectedNode->pivotOffset.x += 0.01f; poseChanged = true; }
         ImGui::PopButtonRepeat();
 
         ImGui::PushItemWidth(input_width);
-        ImGui::InputFloat("Y##OffsetY", &selectedNode->pivotOffset.y, 0.0f, 0.0f, "%.4f");
+        poseChanged |= ImGui::InputFloat("Y##OffsetY", &selectedNode->pivotOffset.y, 0.0f, 0.0f, "%.4f");
         ImGui::PopItemWidth(); ImGui::SameLine(0.0f, button_spacing);
         ImGui::PushButtonRepeat(true);
-        if (ImGui::Button("-##OffsetY", ImVec2(button_width, 0))) { selectedNode->pivotOffset.y -= 0.01f; }
+        if (ImGui::Button("-##OffsetY", ImVec2(button_width, 0))) { selectedNode->pivotOffset.y -= 0.01f; poseChanged = true; }
         ImGui::SameLine(0.0f, button_spacing);
-        if (ImGui::Button("+##OffsetY", ImVec2(button_width, 0))) { selectedNode->pivotOffset.y += 0.01f; }
+        if (ImGui::Button("+##OffsetY", ImVec2(button_width, 0))) { selectedNode->pivotOffset.y += 0.01f; poseChanged = true; }
         ImGui::PopButtonRepeat();
 
         ImGui::Separator();
         ImGui::Text("Angle");
         ImGui::PushItemWidth(input_width);
-        ImGui::InputFloat("##AngleInput", &selectedNode->angle, 0.0f, 0.0f, "%.1f");
+        poseChanged |= ImGui::InputFloat("##AngleInput", &selectedNode->angle, 0.0f, 0.0f, "%.1f");
         ImGui::PopItemWidth(); ImGui::SameLine(0.0f, button_spacing);
         ImGui::PushButtonRepeat(true);
-        if (ImGui::Button("-##AngleButton", ImVec2(button_width, 0))) { selectedNode->angle -= 1.0f; }
+        if (ImGui::Button("-##AngleButton", ImVec2(button_width, 0))) { selectedNode->angle -= 1.0f; poseChanged = true; }
         ImGui::SameLine(0.0f, button_spacing);
-        if (ImGui::Button("+##AngleButton", ImVec2(button_width, 0))) { selectedNode->angle += 1.0f; }
+        if (ImGui::Button("+##AngleButton", ImVec2(button_width, 0))) { selectedNode->angle += 1.0f; poseChanged = true; }
         ImGui::PopButtonRepeat();
+        if (poseChanged) PivotLogic::MarkNodeDirty(spriteData, selectedNode);
 
         if (spriteData && spriteData->root.get() && selectedNode != spriteData->root.get()) {
             ImGui::Separator();
             ImGui::Text("Hierarchy");
 
-            std::vector<std::unique_ptr<Node>>* childList = nullptr;
-            std::string listName;
-            Node* parentNode = FindParentOfNode(spriteData->root.get(), selectedNode, childList, listName);
+            Node* parentNode = selectedNode->parent;
 
-            if (parentNode && childList) {
+            if (parentNode) {
                 ImGui::Text("Parent: %s", parentNode->name.c_str());
 
-                int selectedIndex = (listName == "ChildrenInFront") ? 0 : 1;
+                int selectedIndex = selectedNode->behind ? 1 : 0;
                 const char* previewValue = (selectedIndex == 0) ? "ChildrenInFront" : "ChildrenBehind";
 
                 ImGui::PushItemWidth(full_width);
@@ -161,14 +144,9 @@ void Editor::Render(SpriteData* spriteData, Node*& selectedNode, bool& showPivot
                     DrawColorDot(COLOR_HIERARCHY_BEHIND);
                     if (ImGui::Selectable("ChildrenBehind", selectedIndex == 1)) { selectedIndex = 1; }
                     ImGui::PopID();
-                    if (((selectedIndex == 0) ? "ChildrenInFront" : "ChildrenBehind") != listName) {
-                        std::vector<std::unique_ptr<Node>>* destinationList = (selectedIndex == 0) ? &parentNode->childrenInFront : &parentNode->childrenBehind;
-                        auto it = std::find_if(childList->begin(), childList->end(), [&](const auto& p) { return p.get() == selectedNode; });
-                        if (it != childList->end()) {
-                            std::unique_ptr<Node> movedNode = std::move(*it);
-                            childList->erase(it);
-                            destinationList->push_back(std::move(movedNode));
-                        }
+                    if (selectedIndex != (selectedNode->behind ? 1 : 0)) {
+                        Hierarchy::Move(selectedNode, parentNode, selectedIndex == 1);
+                        PivotLogic::MarkRigDirty(spriteData);
                     }
                     ImGui::EndCombo();
                 }
@@ -1,7 +1,15 @@
 #include "environment.h"
+#include "vfs.h"
+#include "trace.h"
 #include <fstream>
 #include <vector>
 #include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 extern "C" {
 #include <lua.h>
@@ -16,8 +24,12 @@ namespace Environment {
         std::string g_dynamicPath;
         std::vector<std::string> g_searchPaths;
         std::string g_startupMessage;
+        float g_uploadBudgetMs = 4.0f;
+        bool g_decodeCacheVerifyContent = false;
+        float g_textureBudgetMB = 512.0f;
 
         void RebuildSearchPaths() {
+            Trace::Scope trace("Environment::MountSearchPaths", "environment");
             g_searchPaths.clear();
             if (!g_dynamicPath.empty()) {
                 g_searchPaths.push_back(g_dynamicPath);
@@ -25,10 +37,25 @@ namespace Environment {
             if (!g_baseFortsPath.empty()) {
                 g_searchPaths.push_back(g_baseFortsPath);
             }
+            Vfs::Mount(g_searchPaths);
+        }
+
+        std::filesystem::path ExecutableDirectory() {
+            std::error_code ec;
+#ifdef _WIN32
+            wchar_t buffer[MAX_PATH];
+            DWORD length = GetModuleFileNameW(NULL, buffer, MAX_PATH);
+            if (length > 0 && length < MAX_PATH) return std::filesystem::path(buffer, buffer + length).parent_path();
+#else
+            std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+            if (!ec) return exe.parent_path();
+#endif
+            return std::filesystem::current_path(ec);
         }
     }
 
     void Initialize() {
+        Trace::Scope trace("Environment::Initialize", "environment");
         const char* configFile = "env.lua";
         lua_State* L = luaL_newstate();
 
@@ -38,6 +65,24 @@ namespace Environment {
                 g_baseFortsPath = lua_tostring(L, -1);
             }
             lua_pop(L, 1);
+
+            lua_getglobal(L, "UploadBudgetMs");
+            if (lua_isnumber(L, -1)) {
+                g_uploadBudgetMs = std::max(0.0f, (float)lua_tonumber(L, -1));
+            }
+            lua_pop(L, 1);
+
+            lua_getglobal(L, "DecodeCacheVerifyContent");
+            if (lua_isboolean(L, -1)) {
+                g_decodeCacheVerifyContent = lua_toboolean(L, -1) != 0;
+            }
+            lua_pop(L, 1);
+
+            lua_getglobal(L, "TextureBudgetMB");
+            if (lua_isnumber(L, -1)) {
+                g_textureBudgetMB = std::max(0.0f, (float)lua_tonumber(L, -1));
+            }
+            lua_pop(L, 1);
         }
         else {
             g_baseFortsPath = "C:/Program Files (x86)/Steam/steamapps/common/Forts/data";
@@ -46,6 +91,12 @@ namespace Environment {
                 outFile << "-- Configuration for the Sprite Previewer\n";
                 outFile << "-- Please ensure this path points to your Forts 'data' directory.\n";
                 outFile << "FortsPath = \"" << g_baseFortsPath << "\"\n";
+                outFile << "-- Milliseconds per frame spent streaming textures to the GPU.\n";
+                outFile << "UploadBudgetMs = " << g_uploadBudgetMs << "\n";
+                outFile << "-- Hash texture contents when validating the decoded-texture cache, not just size and time.\n";
+                outFile << "DecodeCacheVerifyContent = false\n";
+                outFile << "-- Textures no longer in use are kept for reuse until this much video memory is used.\n";
+                outFile << "TextureBudgetMB = " << g_textureBudgetMB << "\n";
                 outFile.close();
                 g_startupMessage = "env.lua created. Please verify the FortsPath within it.";
             }
@@ -55,7 +106,14 @@ namespace Environment {
     }
 
     void UpdateSearchPathsForFile(const std::string& scriptPath) {
-        g_dynamicPath.clear();
+        Trace::Scope trace("Environment::UpdateSearchPathsForFile", "environment");
+        trace.Arg("path", scriptPath);
+        g_dynamicPath = ModRootForFile(scriptPath);
+        trace.Arg("mod_root", g_dynamicPath);
+        RebuildSearchPaths();
+    }
+
+    std::string ModRootForFile(const std::string& scriptPath) {
         std::filesystem::path p(scriptPath);
         std::string pathStr = p.lexically_normal().string();
         std::replace(pathStr.begin(), pathStr.end(), '\\', '/');
@@ -66,7 +124,7 @@ namespace Environment {
         if (pos != std::string::npos) {
             size_t mod_root_end = pathStr.find('/', pos + 18);
             if (mod_root_end != std::string::npos) {
-                g_dynamicPath = pathStr.substr(0, mod_root_end);
+                return pathStr.substr(0, mod_root_end);
             }
         }
         else {
@@ -74,11 +132,19 @@ namespace Environment {
             if (pos != std::string::npos) {
                 size_t workshop_item_end = pathStr.find('/', pos + 26);
                 if (workshop_item_end != std::string::npos) {
-                    g_dynamicPath = pathStr.substr(0, workshop_item_end);
+                    return pathStr.substr(0, workshop_item_end);
                 }
             }
         }
-        RebuildSearchPaths();
+        return "";
+    }
+
+    std::vector<std::string> SearchPathsForFile(const std::string& scriptPath) {
+        std::vector<std::string> searchPaths;
+        std::string mod_root = ModRootForFile(scriptPath);
+        if (!mod_root.empty()) searchPaths.push_back(mod_root);
+        if (!g_baseFortsPath.empty()) searchPaths.push_back(g_baseFortsPath);
+        return searchPaths;
     }
 
     const std::vector<std::string>& GetSearchPaths() {
@@ -88,4 +154,21 @@ namespace Environment {
     const std::string& GetStartupMessage() {
         return g_startupMessage;
     }
+
+    float GetUploadBudgetMs() {
+        return g_uploadBudgetMs;
+    }
+
+    bool GetDecodeCacheVerifyContent() {
+        return g_decodeCacheVerifyContent;
+    }
+
+    float GetTextureBudgetMB() {
+        return g_textureBudgetMB;
+    }
+
+    std::filesystem::path CacheDirectory(const std::string& name) {
+        static const std::filesystem::path root = ExecutableDirectory() / "cache";
+        return root / name;
+    }
 }
\ No newline at end of file
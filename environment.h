@@ -5,6 +5,16 @@
 namespace Environment {
 	void Initialize();
 	void UpdateSearchPathsForFile(const std::string& scriptPath);
+	// The mod or workshop item folder containing scriptPath, or empty.
+	std::string ModRootForFile(const std::string& scriptPath);
+	// The search paths a script would get, without changing the current ones.
+	std::vector<std::string> SearchPathsForFile(const std::string& scriptPath);
 	const std::vector<std::string>& GetSearchPaths();
 	const std::string& GetStartupMessage();
+	float GetUploadBudgetMs();
+	bool GetDecodeCacheVerifyContent();
+	float GetTextureBudgetMB();
+	// Absolute <executable directory>/cache/<name>, so on-disk caches do not
+	// depend on the working directory. Safe to call from any thread.
+	std::filesystem::path CacheDirectory(const std::string& name);
 }
\ No newline at end of file
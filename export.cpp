@@ -1,98 +1,111 @@
 #include "export.h"
+#include <charconv>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iterator>
 
 namespace {
-    void GenerateNodeLua(const Node* node, int indentLevel, std::stringstream& ss);
+    // Appends straight into one buffer that keeps its capacity between saves;
+    // separators are written up front so nothing is trimmed afterwards.
+    class LuaWriter {
+    public:
+        explicit LuaWriter(std::string& buffer) : m_buffer(buffer) { m_buffer.clear(); }
 
-    void GenerateSpritesLua(const std::map<std::string, Sprite>& sprites, std::stringstream& ss) {
-        ss << "Sprites =\n{\n";
+        LuaWriter& operator<<(std::string_view text) { m_buffer.append(text.data(), text.size()); return *this; }
+        LuaWriter& operator<<(char c) { m_buffer.push_back(c); return *this; }
+
+        // Matches the previous "%.4f" output.
+        LuaWriter& operator<<(float value) {
+            char number[64];
+            auto result = std::to_chars(number, number + sizeof(number), value, std::chars_format::fixed, 4);
+            m_buffer.append(number, result.ptr);
+            return *this;
+        }
+
+        LuaWriter& Tabs(int count) { m_buffer.append((size_t)count, '\t'); return *this; }
+
+    private:
+        std::string& m_buffer;
+    };
+
+    void GenerateNodeLua(const Node* node, int indentLevel, LuaWriter& out);
+
+    void GenerateStateLua(const SpriteState& state, LuaWriter& out) {
+        out << "{\n";
+        bool first = true;
+        auto field = [&]() -> LuaWriter& {
+            if (!first) out << ",\n";
+            first = false;
+            return out.Tabs(4);
+        };
+        if (!state.frames.empty()) {
+            field() << "Frames =\n\t\t\t\t{\n";
+            for (size_t i = 0; i < state.frames.size(); ++i) {
+                out.Tabs(5) << "{ texture = \"" << state.frames[i].texturePath << "\" }";
+                out << (i + 1 < state.frames.size() ? ",\n" : "\n");
+            }
+            out.Tabs(4) << '}';
+        }
+        if (state.mipmap) field() << "mipmap = true";
+        if (state.duration > 0) field() << "duration = " << state.duration;
+        if (!state.nextState.empty()) field() << "NextState = \"" << state.nextState << '"';
+        out << "\n\t\t\t}";
+    }
+
+    void GenerateSpritesLua(const std::map<std::string, Sprite>& sprites, LuaWriter& out) {
+        out << "Sprites =\n{\n";
         for (auto sprite_it = sprites.begin(); sprite_it != sprites.end(); ++sprite_it) {
             const Sprite& sprite = sprite_it->second;
-            ss << "\t{\n";
-            ss << "\t\tName = \"" << sprite.name << "\",\n";
-            ss << "\t\tStates =\n\t\t{\n";
+            out << "\t{\n";
+            out << "\t\tName = \"" << sprite.name << "\",\n";
+            out << "\t\tStates =\n\t\t{\n";
 
             for (auto state_it = sprite.states.begin(); state_it != sprite.states.end(); ++state_it) {
-                const auto& state_pair = *state_it;
-                ss << "\t\t\t" << state_pair.first << " = ";
-                if (state_pair.second.isLink) {
-                    ss << state_pair.second.linkToStateName;
-                }
-                else {
-                    ss << "{\n";
-                    std::stringstream state_content_ss;
-                    if (!state_pair.second.frames.empty()) {
-                        state_content_ss << "\t\t\t\tFrames =\n\t\t\t\t{\n";
-                        for (const auto& frame : state_pair.second.frames) {
-                            state_content_ss << "\t\t\t\t\t{ texture = \"" << frame.texturePath << "\" },\n";
-                        }
-                        state_content_ss.seekp(-2, std::ios_base::end);
-                        state_content_ss << "\n\t\t\t\t},\n";
-                    }
-                    if (state_pair.second.mipmap) state_content_ss << "\t\t\t\tmipmap = true,\n";
-                    if (state_pair.second.duration > 0) state_content_ss << "\t\t\t\tduration = " << std::fixed << std::setprecision(4) << state_pair.second.duration << ",\n";
-                    if (!state_pair.second.nextState.empty()) state_content_ss << "\t\t\t\tNextState = \"" << state_pair.second.nextState << "\",\n";
-
-                    std::string content_str = state_content_ss.str();
-                    if (!content_str.empty()) {
-                        content_str.pop_back();
-                        content_str.pop_back();
-                    }
-                    ss << content_str << "\n\t\t\t}";
-                }
-                if (std::next(state_it) != sprite.states.end()) ss << ",\n";
-                else ss << "\n";
+                out << "\t\t\t" << state_it->first << " = ";
+                if (state_it->second.isLink) out << state_it->second.linkToStateName;
+                else GenerateStateLua(state_it->second, out);
+                out << (std::next(state_it) != sprite.states.end() ? ",\n" : "\n");
             }
-            ss << "\t\t}\n\t}";
-            if (std::next(sprite_it) != sprites.end()) ss << ",\n";
-            else ss << "\n";
+            out << "\t\t}\n\t}";
+            out << (std::next(sprite_it) != sprites.end() ? ",\n" : "\n");
         }
-        ss << "}\n";
+        out << "}\n";
     }
 
-    void GenerateLuaForChildList(const std::vector<std::unique_ptr<Node>>& children, int indentLevel, std::stringstream& ss, const std::string& listName) {
+    void GenerateLuaForChildList(const std::vector<std::unique_ptr<Node>>& children, int indentLevel, LuaWriter& out, std::string_view listName, bool& first) {
         if (children.empty()) return;
-        std::string t(indentLevel, '\t');
-        ss << t << listName << " =\n" << t << "{\n";
+        if (!first) out << ",\n";
+        first = false;
+        out.Tabs(indentLevel) << listName << " =\n";
+        out.Tabs(indentLevel) << "{\n";
         for (size_t i = 0; i < children.size(); ++i) {
-            GenerateNodeLua(children[i].get(), indentLevel + 1, ss);
-            if (i < children.size() - 1) ss << ",\n";
-            else ss << "\n";
+            GenerateNodeLua(children[i].get(), indentLevel + 1, out);
+            out << (i + 1 < children.size() ? ",\n" : "\n");
         }
-        ss << t << "},\n";
+        out.Tabs(indentLevel) << '}';
     }
 
-    void GenerateNodeLua(const Node* node, int indentLevel, std::stringstream& ss) {
+    void GenerateNodeLua(const Node* node, int indentLevel, LuaWriter& out) {
         if (!node) return;
-        std::string t(indentLevel, '\t');
-        ss << t << "{\n";
-        std::string t_inner = t + "\t";
-
-        ss << std::fixed << std::setprecision(4);
-        ss << t_inner << "Name = \"" << node->name << "\",\n";
-        ss << t_inner << "Angle = " << node->angle << ",\n";
-        ss << t_inner << "Pivot = { " << node->pivot.x << ", " << node->pivot.y << " },\n";
-        ss << t_inner << "PivotOffset = { " << node->pivotOffset.x << ", " << node->pivotOffset.y << " },\n";
+        out.Tabs(indentLevel) << "{\n";
+        const int inner = indentLevel + 1;
+
+        out.Tabs(inner) << "Name = \"" << node->name << "\",\n";
+        out.Tabs(inner) << "Angle = " << node->angle << ",\n";
+        out.Tabs(inner) << "Pivot = { " << node->pivot.x << ", " << node->pivot.y << " },\n";
+        out.Tabs(inner) << "PivotOffset = { " << node->pivotOffset.x << ", " << node->pivotOffset.y << " },\n";
         if (node->sprite_ptr && !node->sprite_ptr->name.empty()) {
-            ss << t_inner << "Sprite = \"" << node->sprite_ptr->name << "\",\n";
+            out.Tabs(inner) << "Sprite = \"" << node->sprite_ptr->name << "\",\n";
         }
 
-        std::stringstream children_ss;
-        GenerateLuaForChildList(node->childrenBehind, indentLevel + 1, children_ss, "ChildrenBehind");
-        GenerateLuaForChildList(node->childrenInFront, indentLevel + 1, children_ss, "ChildrenInFront");
-
-        std::string children_str = children_ss.str();
-        if (!children_str.empty()) {
-            children_str.pop_back();
-            children_str.pop_back();
-        }
-        ss << children_str << "\n";
-        ss << t << "}";
+        bool first = true;
+        GenerateLuaForChildList(node->childrenBehind, inner, out, "ChildrenBehind", first);
+        GenerateLuaForChildList(node->childrenInFront, inner, out, "ChildrenInFront", first);
+        out << '\n';
+        out.Tabs(indentLevel) << '}';
     }
 }
 
@@ -102,21 +115,43 @@ void Export::SaveToFile(const std::string& filePath, const Node* root, const std
         successMessage.clear();
         return;
     }
-    std::stringstream ss;
+    // Batch conversion saves from several threads at once.
+    thread_local std::string buffer;
+    LuaWriter out(buffer);
 
-    GenerateSpritesLua(sprites, ss);
-    ss << "\n";
-    ss << "Root =\n";
-    GenerateNodeLua(root, 0, ss);
+    GenerateSpritesLua(sprites, out);
+    out << "\n";
+    out << "Root =\n";
+    GenerateNodeLua(root, 0, out);
 
-    std::ofstream outFile(filePath);
-    if (!outFile.is_open()) {
-        errorMessage = "Error: Could not open " + filePath + " for writing.";
+    // Write next to the target and rename so a crash never leaves a partial file.
+    std::filesystem::path target = filePath;
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream outFile(temp);
+        if (!outFile.is_open()) {
+            errorMessage = "Error: Could not open " + filePath + " for writing.";
+            successMessage.clear();
+            return;
+        }
+        outFile.write(buffer.data(), buffer.size());
+        if (!outFile) {
+            outFile.close();
+            std::filesystem::remove(temp, ec);
+            errorMessage = "Error: Could not write " + filePath + ".";
+            successMessage.clear();
+            return;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        errorMessage = "Error: Could not replace " + filePath + ".";
         successMessage.clear();
         return;
     }
-    outFile << ss.str();
-    outFile.close();
 
     successMessage = "Successfully exported to " + filePath + "!";
     errorMessage.clear();
@@ -1,6 +1,9 @@
 #include "file_handling.h"
-#include "texture_loader.h"
 #include "environment.h"
+#include "pivot_logic.h"
+#include "hierarchy.h"
+#include "vfs.h"
+#include "trace.h"
 
 #include <filesystem>
 #include <fstream>
@@ -72,7 +75,7 @@ namespace {
     void resolve_sprite_pointers(Node* node, const std::map<std::string, Sprite>& sprites) {
         if (!node) return;
         auto it = sprites.find(node->spriteName);
-        if (it != sprites.end()) node->sprite_ptr = &it->second;
+        node->sprite_ptr = it != sprites.end() ? &it->second : nullptr;
         for (auto& child : node->childrenBehind) resolve_sprite_pointers(child.get(), sprites);
         for (auto& child : node->childrenInFront) resolve_sprite_pointers(child.get(), sprites);
     }
@@ -93,6 +96,7 @@ namespace {
     };
 
     void FindAllStates(SpriteData& data) {
+        data.allAvailableStates.clear();
         if (data.sprites.empty()) return;
         std::set<std::string> allStates;
         for (const auto& sprite_pair : data.sprites) {
@@ -103,7 +107,7 @@ namespace {
         data.allAvailableStates.assign(allStates.begin(), allStates.end());
     }
 
-    void parse_sprite_state(lua_State* L, SpriteState& spriteState, SpriteData& data, std::string& errorMessage) {
+    void parse_sprite_state(lua_State* L, SpriteState& spriteState) {
         lua_getfield(L, -1, "Frames");
         if (lua_istable(L, -1)) {
             lua_pushnil(L);
@@ -113,11 +117,6 @@ namespace {
                     if (lua_isstring(L, -1)) {
                         SpriteFrame frame;
                         frame.texturePath = lua_tostring(L, -1);
-                        frame.textureId = TextureLoader::LoadOrGetTexture(frame.texturePath, data, errorMessage);
-                        if (frame.textureId == 0) { /* error is already set */ }
-                        glBindTexture(GL_TEXTURE_2D, frame.textureId);
-                        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &frame.width);
-                        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &frame.height);
                         spriteState.frames.push_back(frame);
                     }
                     lua_pop(L, 1);
@@ -138,154 +137,249 @@ namespace {
         if (lua_isstring(L, -1)) spriteState.nextState = lua_tostring(L, -1);
         lua_pop(L, 1);
     }
-}
 
-void load_sprite_file(
-    const std::string& script_relative_path,
-    std::unique_ptr<SpriteData>& spriteData,
-    std::string& errorMessage,
-    std::string& successMessage,
-    CanvasState& canvas) {
-
-    errorMessage.clear();
-    successMessage.clear();
-    if (spriteData) {
-        for (auto const& [key, val] : spriteData->loadedTextures) {
-            glDeleteTextures(1, &val);
+    bool run_sprite_script(const std::filesystem::path& script_path, const std::vector<std::string>& searchPaths, SpriteData& data, std::string& errorMessage, bool requireNormalState = true) {
+        lua_State* L = luaL_newstate();
+        luaL_openlibs(L);
+
+        lua_pushcfunction(L, dummy_dofile);
+        lua_setglobal(L, "dofile");
+        lua_pushcfunction(L, dummy_require);
+        lua_setglobal(L, "require");
+
+        std::string path_variable = "";
+        if (searchPaths.size() > 1) {//Inside mod
+            std::filesystem::path mod_root_path = searchPaths[0];
+            std::filesystem::path data_path = searchPaths[1];
+            try {
+                std::filesystem::path relative_path = std::filesystem::relative(mod_root_path, data_path);
+                path_variable = relative_path.string();
+                std::replace(path_variable.begin(), path_variable.end(), '\\', '/');
+                std::string mod_root_str = mod_root_path.string();
+                std::string data_str = data_path.string();
+                size_t pos = mod_root_str.find(data_str);
+                if (pos != std::string::npos) {
+                    path_variable = mod_root_str.substr(pos + data_str.length() + 1);
+                    std::replace(path_variable.begin(), path_variable.end(), '\\', '/');
+                }
+                else {
+                    path_variable = "";
+                }
+
+            }
+            catch (const std::filesystem::filesystem_error& e) {
+                path_variable = "";
+            }
         }
-    }
+        lua_pushstring(L, path_variable.c_str());
+        lua_setglobal(L, "path");
+
 
-    auto find_absolute = [&](const std::string& rel_path) -> std::filesystem::path {
-        std::filesystem::path file_path(rel_path);
-        if (file_path.is_absolute() && std::filesystem::exists(file_path)) return file_path.lexically_normal();
-        for (const auto& base_str : Environment::GetSearchPaths()) {
-            std::filesystem::path full_path = std::filesystem::path(base_str) / file_path;
-            if (std::filesystem::exists(full_path = full_path.lexically_normal())) return full_path;
+        {
+            Trace::Scope trace("lua_dofile", "parse");
+            trace.Arg("path", script_path.string());
+            if (luaL_dofile(L, script_path.string().c_str()) != LUA_OK) {
+                errorMessage = "Lua Error: " + std::string(lua_tostring(L, -1));
+                lua_close(L);
+                return false;
+            }
         }
-        return "";
-        };
 
-    std::filesystem::path script_path = find_absolute(script_relative_path);
-    if (script_path.empty()) {
-        errorMessage = "Main script not found: " + script_relative_path;
-        return;
-    }
+        Trace::Scope tables_trace("read Sprites and Root", "parse");
+        lua_getglobal(L, "Sprites");
+        if (lua_istable(L, -1)) {
+            lua_pushnil(L);
+            while (lua_next(L, -2) != 0) {
+                if (!errorMessage.empty()) break;
+                Sprite s;
+                lua_getfield(L, -1, "Name");
+                if (!lua_isstring(L, -1)) {
+                    errorMessage = "Error: A sprite has no Name.";
+                    lua_close(L); return false;
+                }
+                s.name = lua_tostring(L, -1); lua_pop(L, 1);
 
-    Environment::UpdateSearchPathsForFile(script_relative_path);
-    const auto& searchPaths = Environment::GetSearchPaths();
-    std::filesystem::path base_path = searchPaths.empty() ? "" : searchPaths.front();
+                std::unordered_map<const void*, std::string> seenTables;
 
-    CurrentPathGuard path_guard(base_path);
-    auto data = std::make_unique<SpriteData>();
-    lua_State* L = luaL_newstate();
-    luaL_openlibs(L);
-
-    lua_pushcfunction(L, dummy_dofile);
-    lua_setglobal(L, "dofile");
-    lua_pushcfunction(L, dummy_require);
-    lua_setglobal(L, "require");
-
-    std::string path_variable = "";
-    if (searchPaths.size() > 1) {//Inside mod
-        std::filesystem::path mod_root_path = searchPaths[0];
-        std::filesystem::path data_path = searchPaths[1];
-        try {
-            std::filesystem::path relative_path = std::filesystem::relative(mod_root_path, data_path);
-            path_variable = relative_path.string();
-            std::replace(path_variable.begin(), path_variable.end(), '\\', '/');
-            std::string mod_root_str = mod_root_path.string();
-            std::string data_str = data_path.string();
-            size_t pos = mod_root_str.find(data_str);
-            if (pos != std::string::npos) {
-                path_variable = mod_root_str.substr(pos + data_str.length() + 1);
-                std::replace(path_variable.begin(), path_variable.end(), '\\', '/');
+                lua_getfield(L, -1, "States");
+                if (lua_istable(L, -1)) {
+                    lua_pushnil(L);
+                    while (lua_next(L, -2) != 0) {
+                        const char* stateName = lua_tostring(L, -2);
+                        int valIdx = lua_gettop(L);
+                        const void* ptr = lua_istable(L, valIdx) ? lua_topointer(L, valIdx) : nullptr;
+
+                        if (lua_isstring(L, valIdx)) {
+                            SpriteState linkState;
+                            linkState.isLink = true;
+                            linkState.linkToStateName = lua_tostring(L, valIdx);
+                            s.states[stateName] = linkState;
+                        }
+                        else if (lua_istable(L, valIdx)) {
+                            SpriteState spriteState;
+                            parse_sprite_state(L, spriteState);
+                            s.states[stateName] = spriteState;
+                            seenTables[ptr] = stateName;
+                        }
+                        lua_pop(L, 1);
+                    }
+                }
+                lua_pop(L, 1);
+                for (const auto& pair : s.states) s.stateNames.Add(pair.first);
+
+                if (requireNormalState && s.states.find("Normal") == s.states.end()) {
+                    errorMessage = "Error: Sprite '" + s.name + "' is missing the required 'Normal' state.";
+                    lua_close(L); return false;
+                }
+                data.sprites[s.name] = std::move(s);
+                lua_pop(L, 1);
             }
-            else {
-                path_variable = "";
+            for (const auto& pair : data.sprites) data.spriteNames.Add(pair.first);
+        }
+        lua_pop(L, 1);
+        tables_trace.Arg("sprites", (double)data.sprites.size());
+
+        if (!errorMessage.empty()) {
+            lua_close(L);
+            return false;
+        }
+
+        lua_getglobal(L, "Root");
+        if (lua_istable(L, -1)) {
+            data.root = parse_node(L, lua_gettop(L));
+            resolve_sprite_pointers(data.root.get(), data.sprites);
+            Hierarchy::Link(data);
+        }
+        lua_pop(L, 1);
+        lua_close(L);
+        FindAllStates(data);
+        return true;
+    }
+
+    bool same_sprite(const Sprite& a, const Sprite& b) {
+        if (a.states.size() != b.states.size()) return false;
+        for (auto it_a = a.states.begin(), it_b = b.states.begin(); it_a != a.states.end(); ++it_a, ++it_b) {
+            const SpriteState& state_a = it_a->second;
+            const SpriteState& state_b = it_b->second;
+            if (it_a->first != it_b->first || state_a.isLink != state_b.isLink || state_a.linkToStateName != state_b.linkToStateName) return false;
+            if (state_a.duration != state_b.duration || state_a.mipmap != state_b.mipmap || state_a.nextState != state_b.nextState) return false;
+            if (state_a.frames.size() != state_b.frames.size()) return false;
+            for (size_t i = 0; i < state_a.frames.size(); ++i) {
+                if (state_a.frames[i].texturePath != state_b.frames[i].texturePath) return false;
             }
+        }
+        return true;
+    }
 
+    bool same_tree(const Node* a, const Node* b) {
+        if (!a || !b) return a == b;
+        if (a->name != b->name || a->spriteName != b->spriteName || a->angle != b->angle) return false;
+        if (a->pivot.x != b->pivot.x || a->pivot.y != b->pivot.y || a->pivotOffset.x != b->pivotOffset.x || a->pivotOffset.y != b->pivotOffset.y) return false;
+        if (a->childrenBehind.size() != b->childrenBehind.size() || a->childrenInFront.size() != b->childrenInFront.size()) return false;
+        for (size_t i = 0; i < a->childrenBehind.size(); ++i) {
+            if (!same_tree(a->childrenBehind[i].get(), b->childrenBehind[i].get())) return false;
         }
-        catch (const std::filesystem::filesystem_error& e) {
-            path_variable = "";
+        for (size_t i = 0; i < a->childrenInFront.size(); ++i) {
+            if (!same_tree(a->childrenInFront[i].get(), b->childrenInFront[i].get())) return false;
         }
+        return true;
     }
-    lua_pushstring(L, path_variable.c_str());
-    lua_setglobal(L, "path");
 
+    bool find_name_path(const Node* node, const Node* target, std::vector<std::string>& path) {
+        if (!node) return false;
+        path.push_back(node->name);
+        if (node == target) return true;
+        for (const auto& child : node->childrenBehind) if (find_name_path(child.get(), target, path)) return true;
+        for (const auto& child : node->childrenInFront) if (find_name_path(child.get(), target, path)) return true;
+        path.pop_back();
+        return false;
+    }
 
-    if (luaL_dofile(L, script_path.string().c_str()) != LUA_OK) {
-        errorMessage = "Lua Error: " + std::string(lua_tostring(L, -1));
-        lua_close(L);
-        return;
+    Node* follow_name_path(Node* node, const std::vector<std::string>& path, size_t depth = 0) {
+        if (!node || depth >= path.size() || node->name != path[depth]) return nullptr;
+        if (depth + 1 == path.size()) return node;
+        for (auto& child : node->childrenBehind) if (Node* found = follow_name_path(child.get(), path, depth + 1)) return found;
+        for (auto& child : node->childrenInFront) if (Node* found = follow_name_path(child.get(), path, depth + 1)) return found;
+        return nullptr;
     }
+}
 
-    lua_getglobal(L, "Sprites");
-    if (lua_istable(L, -1)) {
-        lua_pushnil(L);
-        while (lua_next(L, -2) != 0) {
-            if (!errorMessage.empty()) break;
-            Sprite s;
-            lua_getfield(L, -1, "Name"); s.name = lua_tostring(L, -1); lua_pop(L, 1);
+bool parse_sprite_file(const std::string& script_relative_path, SpriteData& data, std::string& errorMessage) {
+    Trace::Scope trace("parse_sprite_file", "parse");
+    trace.Arg("path", script_relative_path);
+    std::filesystem::path script_path = Vfs::Resolve(script_relative_path);
+    if (script_path.empty()) {
+        errorMessage = "Main script not found: " + script_relative_path;
+        return false;
+    }
 
-            std::unordered_map<const void*, std::string> seenTables;
+    Environment::UpdateSearchPathsForFile(script_relative_path);
+    const auto& searchPaths = Environment::GetSearchPaths();
+    std::filesystem::path base_path = searchPaths.empty() ? "" : searchPaths.front();
 
-            lua_getfield(L, -1, "States");
-            if (lua_istable(L, -1)) {
-                lua_pushnil(L);
-                while (lua_next(L, -2) != 0) {
-                    const char* stateName = lua_tostring(L, -2);
-                    int valIdx = lua_gettop(L);
-                    const void* ptr = lua_istable(L, valIdx) ? lua_topointer(L, valIdx) : nullptr;
-
-                    if (lua_isstring(L, valIdx)) {
-                        SpriteState linkState;
-                        linkState.isLink = true;
-                        linkState.linkToStateName = lua_tostring(L, valIdx);
-                        s.states[stateName] = linkState;
-                    }
-                    else if (lua_istable(L, valIdx)) {
-                        SpriteState spriteState;
-                        parse_sprite_state(L, spriteState, *data, errorMessage);
-                        if (!errorMessage.empty()) { lua_close(L); return; }
-                        s.states[stateName] = spriteState;
-                        seenTables[ptr] = stateName;
-                    }
-                    lua_pop(L, 1);
-                }
-            }
-            lua_pop(L, 1);
+    CurrentPathGuard path_guard(base_path);
+    data.scriptPath = script_relative_path;
+    data.scriptFile = script_path.string();
+    return run_sprite_script(script_path, searchPaths, data, errorMessage);
+}
 
-            if (s.states.find("Normal") == s.states.end()) {
-                errorMessage = "Error: Sprite '" + s.name + "' is missing the required 'Normal' state.";
-                lua_close(L); return;
-            }
-            data->sprites[s.name] = std::move(s);
-            lua_pop(L, 1);
-        }
+bool parse_sprite_file(const std::string& script_relative_path, const std::vector<std::string>& searchPaths, SpriteData& data, std::string& errorMessage, bool requireNormalState) {
+    Trace::Scope trace("parse_sprite_file", "parse");
+    trace.Arg("path", script_relative_path);
+    std::filesystem::path script_path = Vfs::Resolve(script_relative_path, searchPaths, {});
+    if (script_path.empty()) {
+        errorMessage = "Main script not found: " + script_relative_path;
+        return false;
     }
-    lua_pop(L, 1);
+    data.scriptPath = script_relative_path;
+    data.scriptFile = script_path.string();
+    return run_sprite_script(script_path, searchPaths, data, errorMessage, requireNormalState);
+}
 
-    if (!errorMessage.empty()) {
-        lua_close(L);
-        return;
+int merge_sprite_data(SpriteData& spriteData, SpriteData& fresh, Node*& selectedNode, bool& treeChanged) {
+    // Map nodes keep their address when the value is reassigned, so
+    // Node::sprite_ptr stays valid for sprites that survive the reload.
+    int changed_sprites = 0;
+    for (auto it = spriteData.sprites.begin(); it != spriteData.sprites.end();) {
+        if (fresh.sprites.count(it->first)) {
+            ++it;
+            continue;
+        }
+        it = spriteData.sprites.erase(it);
+        ++changed_sprites;
     }
-
-    FindAllStates(*data);
-
-    lua_getglobal(L, "Root");
-    if (lua_istable(L, -1)) {
-        data->root = parse_node(L, lua_gettop(L));
-        resolve_sprite_pointers(data->root.get(), data->sprites);
+    for (auto& [name, sprite] : fresh.sprites) {
+        auto it = spriteData.sprites.find(name);
+        if (it == spriteData.sprites.end()) {
+            spriteData.sprites.emplace(name, std::move(sprite));
+            ++changed_sprites;
+        }
+        else if (!same_sprite(it->second, sprite)) {
+            it->second = std::move(sprite);
+            ++changed_sprites;
+        }
     }
-    lua_pop(L, 1);
-    lua_close(L);
 
-    size_t totalStates = 0;
-    for (const auto& pair : data->sprites) {
-        totalStates += pair.second.states.size();
+    spriteData.spriteNames.Clear();
+    for (const auto& pair : spriteData.sprites) spriteData.spriteNames.Add(pair.first);
+
+    treeChanged = !same_tree(spriteData.root.get(), fresh.root.get());
+    if (treeChanged) {
+        std::vector<std::string> selected_path;
+        find_name_path(spriteData.root.get(), selectedNode, selected_path);
+        spriteData.root = std::move(fresh.root);
+        Hierarchy::Link(spriteData);
+        selectedNode = follow_name_path(spriteData.root.get(), selected_path);
     }
-    successMessage = "Loaded " + std::to_string(data->sprites.size()) + " sprites with " + std::to_string(totalStates) + " total states successfully!";
-    canvas.pan = { 0.0f, 0.0f };
-    canvas.zoom = 1.0f;
-    spriteData = std::move(data);
+    resolve_sprite_pointers(spriteData.root.get(), spriteData.sprites);
+    spriteData.allAvailableStates = std::move(fresh.allAvailableStates);
+    PivotLogic::MarkRigDirty(&spriteData);
+    return changed_sprites;
 }
+
+std::vector<std::string> watched_files(const SpriteData& spriteData) {
+    std::vector<std::string> files;
+    if (!spriteData.scriptFile.empty()) files.push_back(spriteData.scriptFile);
+    for (const auto& [source, count] : spriteData.textureRefs) files.push_back(source);
+    return files;
+}
\ No newline at end of file
@@ -2,12 +2,20 @@
 
 #include "datatypes.h"
 #include <string>
-#include <memory>
-
-void load_sprite_file(
-    const std::string& script_relative_path,
-    std::unique_ptr<SpriteData>& spriteData,
-    std::string& errorMessage,
-    std::string& successMessage,
-    CanvasState& canvas
-);
\ No newline at end of file
+#include <vector>
+
+// Runs the script and fills sprites, root and states; textures are left to
+// the caller. On failure errorMessage is set and data is incomplete.
+bool parse_sprite_file(const std::string& script_relative_path, SpriteData& data, std::string& errorMessage);
+// Thread-safe variant for headless tools: resolves against the given search
+// paths and leaves the global search paths and working directory alone.
+// Linting passes requireNormalState = false to report that itself.
+bool parse_sprite_file(const std::string& script_relative_path, const std::vector<std::string>& searchPaths, SpriteData& data, std::string& errorMessage, bool requireNormalState = true);
+
+// Moves a freshly parsed script into spriteData so that unchanged sprites and
+// the node tree survive. selectedNode follows its name path when the tree is
+// replaced. Returns the number of sprites added, removed or changed.
+int merge_sprite_data(SpriteData& spriteData, SpriteData& fresh, Node*& selectedNode, bool& treeChanged);
+
+// The resolved script and texture files a hot reload depends on.
+std::vector<std::string> watched_files(const SpriteData& spriteData);
\ No newline at end of file
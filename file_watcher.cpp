@@ -0,0 +1,191 @@
+#include "file_watcher.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::chrono::milliseconds SETTLE_TIME(200);
+    constexpr std::chrono::milliseconds POLL_INTERVAL(500);
+
+    struct Stamp {
+        std::filesystem::file_time_type mtime;
+        uintmax_t size = 0;
+        bool exists = false;
+    };
+
+    // Keyed by the normalized path, valued by the string the caller passed in.
+    std::map<std::string, std::string> g_files;
+    std::map<std::string, Clock::time_point> g_pending;
+
+#ifdef __linux__
+    int g_inotify = -1;
+    std::map<int, std::filesystem::path> g_watchDirs;
+#endif
+    // Polling stats every file on a pool thread; the UI thread only applies
+    // the finished scan.
+    struct Scan {
+        std::vector<std::pair<std::string, Stamp>> stamps;
+        std::atomic<bool> done{ false };
+    };
+    bool g_polling = false;
+    std::map<std::string, Stamp> g_stamps;
+    std::shared_ptr<Scan> g_scan;
+    Clock::time_point g_lastPoll;
+
+    std::string normalize(const std::filesystem::path& path) {
+        return path.lexically_normal().string();
+    }
+
+    Stamp stamp_of(const std::string& path) {
+        Stamp stamp;
+        std::error_code ec;
+        stamp.mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) return stamp;
+        stamp.size = std::filesystem::file_size(path, ec);
+        stamp.exists = !ec;
+        return stamp;
+    }
+
+    void mark_changed(const std::string& key) {
+        if (g_files.count(key)) g_pending[key] = Clock::now();
+    }
+
+#ifdef __linux__
+    // Watches the directories of g_files, touching only the ones that were
+    // added or dropped. Queued events for directories that stay are kept.
+    bool update_inotify() {
+        if (g_inotify < 0) g_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (g_inotify < 0) return false;
+
+        std::set<std::string> dirs;
+        for (const auto& file : g_files) dirs.insert(std::filesystem::path(file.first).parent_path().string());
+        for (auto it = g_watchDirs.begin(); it != g_watchDirs.end();) {
+            if (dirs.erase(it->second.string())) {
+                ++it;
+                continue;
+            }
+            inotify_rm_watch(g_inotify, it->first);
+            it = g_watchDirs.erase(it);
+        }
+        for (const auto& dir : dirs) {
+            int wd = inotify_add_watch(g_inotify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB);
+            if (wd >= 0) g_watchDirs[wd] = dir;
+        }
+        return true;
+    }
+
+    void drain_inotify() {
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (true) {
+            ssize_t length = read(g_inotify, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                auto dir = g_watchDirs.find(event->wd);
+                if (dir != g_watchDirs.end() && event->len > 0) {
+                    mark_changed(normalize(dir->second / event->name));
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+
+    void poll_stamps() {
+        if (g_scan) {
+            if (!g_scan->done.load(std::memory_order_acquire)) return;
+            for (const auto& [key, current] : g_scan->stamps) {
+                auto it = g_stamps.find(key);
+                if (it == g_stamps.end()) continue;
+                Stamp& stamp = it->second;
+                if (current.exists != stamp.exists || current.size != stamp.size || current.mtime != stamp.mtime) {
+                    stamp = current;
+                    mark_changed(key);
+                }
+            }
+            g_scan.reset();
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now - g_lastPoll < POLL_INTERVAL) return;
+        g_lastPoll = now;
+        auto scan = std::make_shared<Scan>();
+        scan->stamps.reserve(g_stamps.size());
+        for (const auto& entry : g_stamps) scan->stamps.emplace_back(entry.first, Stamp());
+        g_scan = scan;
+        ThreadPool::Submit([scan] {
+            for (auto& [key, stamp] : scan->stamps) stamp = stamp_of(key);
+            scan->done.store(true, std::memory_order_release);
+        });
+    }
+}
+
+void FileWatcher::Watch(const std::vector<std::string>& files) {
+    // Updated in place rather than restarted, so changes still settling,
+    // queued events and stamps of files that stay watched survive a reload.
+    std::map<std::string, std::string> watched;
+    for (const auto& file : files) {
+        if (!file.empty()) watched[normalize(file)] = file;
+    }
+    g_files = std::move(watched);
+    for (auto it = g_pending.begin(); it != g_pending.end();) {
+        if (g_files.count(it->first)) ++it;
+        else it = g_pending.erase(it);
+    }
+#ifdef __linux__
+    if (!g_polling && update_inotify()) return;
+#endif
+    if (!g_polling) g_lastPoll = Clock::now();
+    g_polling = true;
+    for (auto it = g_stamps.begin(); it != g_stamps.end();) {
+        if (g_files.count(it->first)) ++it;
+        else it = g_stamps.erase(it);
+    }
+    for (const auto& file : g_files) {
+        if (!g_stamps.count(file.first)) g_stamps[file.first] = stamp_of(file.first);
+    }
+}
+
+std::set<std::string> FileWatcher::PollChanges() {
+#ifdef __linux__
+    if (g_inotify >= 0) drain_inotify();
+    else poll_stamps();
+#else
+    poll_stamps();
+#endif
+    std::set<std::string> settled;
+    Clock::time_point now = Clock::now();
+    for (auto it = g_pending.begin(); it != g_pending.end();) {
+        if (now - it->second < SETTLE_TIME) {
+            ++it;
+            continue;
+        }
+        settled.insert(g_files[it->first]);
+        it = g_pending.erase(it);
+    }
+    return settled;
+}
+
+void FileWatcher::Stop() {
+#ifdef __linux__
+    if (g_inotify >= 0) close(g_inotify);
+    g_inotify = -1;
+    g_watchDirs.clear();
+#endif
+    g_files.clear();
+    g_pending.clear();
+    g_polling = false;
+    g_stamps.clear();
+    g_scan.reset();
+}
\ No newline at end of file
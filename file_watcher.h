@@ -0,0 +1,15 @@
+#pragma once
+#include <set>
+#include <string>
+#include <vector>
+
+namespace FileWatcher {
+    // Replaces the watched set, keeping pending changes of files that stay.
+    // Uses inotify on the files' directories on Linux and falls back to
+    // polling size/mtime on a pool thread elsewhere.
+    void Watch(const std::vector<std::string>& files);
+    // Files that changed and have been quiet for a short settle time, so
+    // editors that write in several steps are reported once. Non-blocking.
+    std::set<std::string> PollChanges();
+    void Stop();
+}
\ No newline at end of file
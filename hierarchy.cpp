@@ -0,0 +1,115 @@
+#include "hierarchy.h"
+#include <algorithm>
+
+namespace {
+    void register_node(SpriteData& data, Node* node) {
+        std::uint32_t slot;
+        if (!data.freeSlots.empty()) {
+            slot = data.freeSlots.back();
+            data.freeSlots.pop_back();
+        }
+        else {
+            if (data.nodeSlots.empty()) data.nodeSlots.emplace_back();
+            slot = (std::uint32_t)data.nodeSlots.size();
+            data.nodeSlots.emplace_back();
+        }
+        data.nodeSlots[slot].node = node;
+        node->slot = slot;
+    }
+
+    void unregister_node(SpriteData& data, Node* node) {
+        if (node->slot == 0 || node->slot >= data.nodeSlots.size() || data.nodeSlots[node->slot].node != node) return;
+        NodeSlot& slot = data.nodeSlots[node->slot];
+        slot.node = nullptr;
+        ++slot.generation;
+        data.freeSlots.push_back(node->slot);
+        node->slot = 0;
+    }
+
+    void link_subtree(SpriteData& data, Node* node, Node* parent, bool behind) {
+        node->parent = parent;
+        node->behind = behind;
+        register_node(data, node);
+        data.nodeNames.Add(node->name);
+        for (auto& child : node->childrenBehind) link_subtree(data, child.get(), node, true);
+        for (auto& child : node->childrenInFront) link_subtree(data, child.get(), node, false);
+    }
+
+    std::unique_ptr<Node> detach(Node* node) {
+        auto& list = Hierarchy::SiblingList(node);
+        auto it = std::find_if(list.begin(), list.end(), [&](const auto& p) { return p.get() == node; });
+        std::unique_ptr<Node> detached = std::move(*it);
+        list.erase(it);
+        return detached;
+    }
+}
+
+void Hierarchy::Link(SpriteData& data) {
+    data.freeSlots.clear();
+    data.nodeNames.Clear();
+    for (std::uint32_t i = (std::uint32_t)data.nodeSlots.size(); i-- > 1;) {
+        NodeSlot& slot = data.nodeSlots[i];
+        if (slot.node) {
+            slot.node = nullptr;
+            ++slot.generation;
+        }
+        data.freeSlots.push_back(i);
+    }
+    if (data.root) link_subtree(data, data.root.get(), nullptr, false);
+}
+
+NodeHandle Hierarchy::HandleOf(const SpriteData& data, const Node* node) {
+    if (!node || node->slot == 0 || node->slot >= data.nodeSlots.size() || data.nodeSlots[node->slot].node != node) return {};
+    return { node->slot, data.nodeSlots[node->slot].generation };
+}
+
+Node* Hierarchy::Resolve(const SpriteData& data, NodeHandle handle) {
+    if (handle.generation == 0 || handle.index >= data.nodeSlots.size()) return nullptr;
+    const NodeSlot& slot = data.nodeSlots[handle.index];
+    return slot.generation == handle.generation ? slot.node : nullptr;
+}
+
+bool Hierarchy::IsDescendant(const Node* ancestor, const Node* node) {
+    if (!ancestor || !node) return false;
+    for (const Node* p = node->parent; p; p = p->parent) {
+        if (p == ancestor) return true;
+    }
+    return false;
+}
+
+std::vector<std::unique_ptr<Node>>& Hierarchy::SiblingList(Node* node) {
+    return node->behind ? node->parent->childrenBehind : node->parent->childrenInFront;
+}
+
+Node* Hierarchy::AddChild(SpriteData& data, Node* parent, std::unique_ptr<Node> child, bool behind) {
+    Node* added = child.get();
+    (behind ? parent->childrenBehind : parent->childrenInFront).push_back(std::move(child));
+    link_subtree(data, added, parent, behind);
+    return added;
+}
+
+void Hierarchy::Remove(SpriteData& data, Node* node) {
+    if (!node || !node->parent) return;
+    Node* parent = node->parent;
+    std::unique_ptr<Node> removed = detach(node);
+    for (auto& child : removed->childrenInFront) {
+        child->parent = parent;
+        child->behind = false;
+        parent->childrenInFront.push_back(std::move(child));
+    }
+    for (auto& child : removed->childrenBehind) {
+        child->parent = parent;
+        child->behind = true;
+        parent->childrenBehind.push_back(std::move(child));
+    }
+    unregister_node(data, removed.get());
+    data.nodeNames.Remove(removed->name);
+}
+
+void Hierarchy::Move(Node* node, Node* newParent, bool behind) {
+    if (!node || !node->parent || !newParent) return;
+    std::unique_ptr<Node> moved = detach(node);
+    node->parent = newParent;
+    node->behind = behind;
+    (behind ? newParent->childrenBehind : newParent->childrenInFront).push_back(std::move(moved));
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include "datatypes.h"
+#include <memory>
+#include <vector>
+
+// Parent links and the node table behind NodeHandle. Edits that go through
+// these functions keep both current, so parent lookup, reparenting, deletion
+// and handle checks do not search the tree.
+namespace Hierarchy {
+    // Sets every parent link and registers every node of a freshly built or
+    // replaced tree. Handles taken before resolve to null afterwards.
+    void Link(SpriteData& data);
+
+    NodeHandle HandleOf(const SpriteData& data, const Node* node);
+    // The node, or null if it was deleted since the handle was taken.
+    Node* Resolve(const SpriteData& data, NodeHandle handle);
+
+    bool IsDescendant(const Node* ancestor, const Node* node);
+    // The parent's list that holds node; node must have a parent.
+    std::vector<std::unique_ptr<Node>>& SiblingList(Node* node);
+
+    Node* AddChild(SpriteData& data, Node* parent, std::unique_ptr<Node> child, bool behind);
+    // Deletes node; its children move to the end of the parent's matching lists.
+    void Remove(SpriteData& data, Node* node);
+    // Moves node with its subtree to the end of newParent's front or behind list.
+    void Move(Node* node, Node* newParent, bool behind);
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "image_decoder.h"
+#include "decode_cache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <il/il.h>
+#include <IL/ilu.h>
+
+namespace {
+    // DevIL keeps its bound image and error state in globals, so only one
+    // thread may be inside it at a time.
+    std::mutex g_devilMutex;
+
+    bool ReadFileBytes(const std::filesystem::path& found_path, std::vector<char>& buffer, std::string& errorMessage) {
+        std::ifstream file(found_path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            errorMessage = "Error: Could not open file " + found_path.string();
+            return false;
+        }
+        buffer.resize((size_t)file.tellg());
+        file.seekg(0, std::ios::beg);
+        if (!file.read(buffer.data(), buffer.size())) {
+            errorMessage = "Error: Could not read file " + found_path.string();
+            return false;
+        }
+        return true;
+    }
+
+    // Thread-safe decoder for the truecolor/grayscale TGAs most mods ship, so
+    // those skip the DevIL lock. Returns false for anything it does not handle.
+    bool DecodeTGA(const std::vector<char>& buffer, DecodedImage& image) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer.data());
+        const size_t size = buffer.size();
+        if (size < 18) return false;
+
+        const int id_length = data[0];
+        const int color_map_type = data[1];
+        const int image_type = data[2];
+        const int width = data[12] | (data[13] << 8);
+        const int height = data[14] | (data[15] << 8);
+        const int bpp = data[16];
+        const int descriptor = data[17];
+        const bool rle = image_type == 10 || image_type == 11;
+        const bool gray = image_type == 3 || image_type == 11;
+
+        if (color_map_type != 0 || (image_type != 2 && image_type != 3 && image_type != 10 && image_type != 11)) return false;
+        if (gray ? bpp != 8 : (bpp != 24 && bpp != 32)) return false;
+        if ((descriptor & 0x10) || width <= 0 || height <= 0) return false;
+
+        const int bytes_per_pixel = bpp / 8;
+        const size_t pixel_count = (size_t)width * height;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(pixel_count * 4);
+
+        auto expand = [&](const unsigned char* src, unsigned char* dst) {
+            if (gray) { dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 255; return; }
+            dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+            dst[3] = bytes_per_pixel == 4 ? src[3] : 255;
+        };
+
+        size_t pos = 18 + (size_t)id_length;
+        size_t written = 0;
+        while (written < pixel_count) {
+            size_t run = pixel_count - written;
+            bool repeat = false;
+            if (rle) {
+                if (pos >= size) return false;
+                unsigned char packet = data[pos++];
+                repeat = (packet & 0x80) != 0;
+                run = std::min(run, (size_t)(packet & 0x7F) + 1);
+            }
+            size_t needed = (repeat ? 1 : run) * bytes_per_pixel;
+            if (pos + needed > size) return false;
+            for (size_t i = 0; i < run; ++i) {
+                expand(data + pos + (repeat ? 0 : i * bytes_per_pixel), image.pixels.data() + (written + i) * 4);
+            }
+            pos += needed;
+            written += run;
+        }
+
+        // Bottom-left origin unless bit 5 is set; store top row first.
+        if (!(descriptor & 0x20)) {
+            const size_t stride = (size_t)width * 4;
+            for (int row = 0; row < height / 2; ++row) {
+                std::swap_ranges(image.pixels.begin() + row * stride, image.pixels.begin() + (row + 1) * stride,
+                    image.pixels.begin() + (height - 1 - row) * stride);
+            }
+        }
+        return true;
+    }
+
+    bool is_tga(const std::filesystem::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".tga";
+    }
+
+    uint32_t read_le32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+    uint32_t read_be32(const unsigned char* p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+    int read_be16(const unsigned char* p) { return (p[0] << 8) | p[1]; }
+
+    // Walks the JPEG segments up to the first start-of-frame marker.
+    bool ReadJpegSize(std::ifstream& file, int& width, int& height) {
+        file.seekg(2, std::ios::beg);
+        unsigned char marker[4];
+        while (file.read(reinterpret_cast<char*>(marker), 4)) {
+            if (marker[0] != 0xFF) return false;
+            if (marker[1] == 0xFF) { file.seekg(-3, std::ios::cur); continue; }
+            const int length = read_be16(marker + 2);
+            const bool sof = marker[1] >= 0xC0 && marker[1] <= 0xCF && marker[1] != 0xC4 && marker[1] != 0xC8 && marker[1] != 0xCC;
+            if (sof) {
+                unsigned char frame[5];
+                if (!file.read(reinterpret_cast<char*>(frame), 5)) return false;
+                height = read_be16(frame + 1);
+                width = read_be16(frame + 3);
+                return true;
+            }
+            if (length < 2) return false;
+            file.seekg(length - 2, std::ios::cur);
+        }
+        return false;
+    }
+
+    bool ReadHeaderSize(const std::filesystem::path& found_path, int& width, int& height) {
+        std::ifstream file(found_path, std::ios::binary);
+        unsigned char header[32] = {};
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) && file.gcount() < 18) return false;
+        file.clear();
+
+        if (memcmp(header, "DDS ", 4) == 0) {
+            height = (int)read_le32(header + 12);
+            width = (int)read_le32(header + 16);
+        }
+        else if (memcmp(header, "\x89PNG\r\n\x1a\n", 8) == 0) {
+            width = (int)read_be32(header + 16);
+            height = (int)read_be32(header + 20);
+        }
+        else if (header[0] == 0xFF && header[1] == 0xD8) {
+            if (!ReadJpegSize(file, width, height)) return false;
+        }
+        else if (header[0] == 'B' && header[1] == 'M') {
+            width = (int)read_le32(header + 18);
+            height = std::abs((int)read_le32(header + 22));
+        }
+        else if (is_tga(found_path)) {
+            width = header[12] | (header[13] << 8);
+            height = header[14] | (header[15] << 8);
+        }
+        else {
+            return false;
+        }
+        return width > 0 && height > 0;
+    }
+
+    // For all other formats, use DevIL. Pixels come back as RGBA8, top row first.
+    // Safe to call from worker threads.
+    bool DecodeImage(const std::filesystem::path& found_path, DecodedImage& image, std::string& errorMessage) {
+        std::vector<char> buffer;
+        if (!ReadFileBytes(found_path, buffer, errorMessage)) return false;
+        if (is_tga(found_path) && DecodeTGA(buffer, image)) return true;
+
+        std::lock_guard<std::mutex> lock(g_devilMutex);
+        ILuint imageID;
+        ilGenImages(1, &imageID); ilBindImage(imageID);
+        if (!ilLoadL(IL_TYPE_UNKNOWN, buffer.data(), buffer.size())) {
+            ILenum err = ilGetError();
+            errorMessage = "DevIL Load Error " + std::to_string(err);
+            ilDeleteImages(1, &imageID); return false;
+        }
+        if (ilGetInteger(IL_IMAGE_ORIGIN) == IL_ORIGIN_LOWER_LEFT) iluFlipImage();
+        if (!ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE)) {
+            ILenum err = ilGetError();
+            errorMessage = "DevIL Convert Error " + std::to_string(err);
+            ilDeleteImages(1, &imageID); return false;
+        }
+
+        image.width = ilGetInteger(IL_IMAGE_WIDTH);
+        image.height = ilGetInteger(IL_IMAGE_HEIGHT);
+        const unsigned char* data = ilGetData();
+        image.pixels.assign(data, data + (size_t)image.width * image.height * 4);
+        ilDeleteImages(1, &imageID);
+        return true;
+    }
+}
+
+bool ImageDecoder::Decode(const std::filesystem::path& path, DecodedImage& image, std::string& errorMessage) {
+    if (DecodeCache::Load(path, image.width, image.height, image.pixels)) return true;
+    if (!DecodeImage(path, image, errorMessage)) return false;
+    DecodeCache::Store(path, image.width, image.height, image.pixels);
+    return true;
+}
+
+bool ImageDecoder::DecodeUncached(const std::filesystem::path& path, DecodedImage& image, std::string& errorMessage) {
+    return DecodeImage(path, image, errorMessage);
+}
+
+bool ImageDecoder::ReadSize(const std::filesystem::path& path, int& width, int& height, std::string& errorMessage) {
+    if (ReadHeaderSize(path, width, height)) return true;
+    DecodedImage image;
+    if (!Decode(path, image, errorMessage)) return false;
+    width = image.width;
+    height = image.height;
+    return true;
+}
+
+bool ImageDecoder::SavePNG(const std::filesystem::path& path, const DecodedImage& image, std::string& errorMessage) {
+    std::vector<unsigned char> encoded;
+    {
+        std::lock_guard<std::mutex> lock(g_devilMutex);
+        ILuint imageID;
+        ilGenImages(1, &imageID); ilBindImage(imageID);
+        bool ok = ilTexImage(image.width, image.height, 1, 4, IL_RGBA, IL_UNSIGNED_BYTE, const_cast<unsigned char*>(image.pixels.data())) && ilRegisterOrigin(IL_ORIGIN_UPPER_LEFT);
+        if (ok) {
+            encoded.resize(ilDetermineSize(IL_PNG));
+            ok = !encoded.empty() && ilSaveL(IL_PNG, encoded.data(), (ILuint)encoded.size()) > 0;
+        }
+        if (!ok) errorMessage = "DevIL Save Error " + std::to_string(ilGetError());
+        ilDeleteImages(1, &imageID);
+        if (!ok) return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size())) {
+        errorMessage = "Error: Could not write " + path.string();
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+namespace ImageDecoder {
+    // Decodes any image DevIL reads (TGAs take a lock-free path) to RGBA8,
+    // top row first, going through the on-disk DecodeCache. Thread-safe.
+    bool Decode(const std::filesystem::path& path, DecodedImage& image, std::string& errorMessage);
+    // The same decode without consulting or filling the DecodeCache.
+    bool DecodeUncached(const std::filesystem::path& path, DecodedImage& image, std::string& errorMessage);
+    // Reads only the header for the size. DDS, TGA, PNG, JPG and BMP are
+    // parsed directly; other formats fall back to a full Decode.
+    bool ReadSize(const std::filesystem::path& path, int& width, int& height, std::string& errorMessage);
+    // Encodes RGBA8 pixels, top row first, as a PNG file. Thread-safe.
+    bool SavePNG(const std::filesystem::path& path, const DecodedImage& image, std::string& errorMessage);
+}
\ No newline at end of file
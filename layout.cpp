@@ -1,6 +1,8 @@
 #include "layout.h"
 #include "datatypes.h"
 #include "file_handling.h"
+#include "hierarchy.h"
+#include "project_loader.h"
 #include "editor.h"
 #include "canvas.h"
 #include "outliner.h"
@@ -11,6 +13,14 @@
 #include "environment.h"
 #include "file_dialog.h"
 #include "hotkeys.h"
+#include "texture_loader.h"
+#include "texture_upload.h"
+#include "texture_cache.h"
+#include "file_watcher.h"
+#include "vfs.h"
+#include "theme.h"
+#include "profiler.h"
+#include "trace.h"
 
 #include <imgui.h>
 #include <il/il.h>
@@ -26,14 +36,11 @@ namespace {
     std::string g_errorMessage;
     std::string g_successMessage;
     CanvasState g_canvas;
-    Node* g_selectedNode = nullptr;
+    // Held as a handle between frames so a deleted or reloaded node reads as
+    // no selection instead of a dangling pointer.
+    NodeHandle g_selection;
     bool g_showPivots = false;
 
-    Node* g_dragDropSourceNode = nullptr;
-    Node* g_dragDropTargetNode = nullptr;
-    Node* g_nodeToDelete = nullptr;
-    Node* g_nodeToAddChildTo = nullptr;
-
     std::string g_activeState = "Normal";
     bool g_isPlaying = false;
     int g_activeFrame = 0;
@@ -66,6 +73,7 @@ namespace SpritePreviewer {
             g_spriteData = std::make_unique<SpriteData>();
             g_spriteData->root = std::make_unique<Node>();
             g_spriteData->root->name = "Root";
+            Hierarchy::Link(*g_spriteData);
             g_activeState = "Normal";
         }
     }
@@ -99,7 +107,9 @@ namespace SpritePreviewer {
     void LoadFile(const std::string& path) {
         g_startupNotification.clear();
         load_sprite_file(path, g_spriteData, g_errorMessage, g_successMessage, g_canvas);
-        g_selectedNode = nullptr;
+        g_selection = NodeHandle();
+        if (g_errorMessage.empty() && g_spriteData) FileWatcher::Watch(watched_files(*g_spriteData));
+        else FileWatcher::Stop();
         if (g_spriteData) {
             g_activeState = g_spriteData->defaultState;
             g_maxFrames = CalculateMaxFrames(g_spriteData.get(), g_activeState);
@@ -111,10 +121,13 @@ namespace SpritePreviewer {
     }
 
     void NewProject() {
+        FileWatcher::Stop();
+        if (g_spriteData) { TextureLoader::ReleaseTextures(*g_spriteData); }
         g_spriteData = std::make_unique<SpriteData>();
         g_spriteData->root = std::make_unique<Node>();
         g_spriteData->root->name = "Root";
-        g_selectedNode = nullptr;
+        Hierarchy::Link(*g_spriteData);
+        g_selection = NodeHandle();
         g_activeState = "Normal";
         g_maxFrames = 1;
         g_activeFrame = 0;
@@ -122,6 +135,21 @@ namespace SpritePreviewer {
         g_successMessage = "New project created.";
     }
 
+    void ProcessHotReload() {
+        if (!g_spriteData || g_spriteData->scriptFile.empty()) return;
+        std::set<std::string> changed = FileWatcher::PollChanges();
+        if (changed.empty()) return;
+
+        Node* selectedNode = Hierarchy::Resolve(*g_spriteData, g_selection);
+        reload_sprite_file(changed, *g_spriteData, selectedNode, g_errorMessage, g_successMessage);
+        g_selection = Hierarchy::HandleOf(*g_spriteData, selectedNode);
+        const auto& states = g_spriteData->allAvailableStates;
+        if (std::find(states.begin(), states.end(), g_activeState) == states.end()) g_activeState = g_spriteData->defaultState;
+        g_maxFrames = CalculateMaxFrames(g_spriteData.get(), g_activeState);
+        g_activeFrame = min(g_activeFrame, g_maxFrames - 1);
+        FileWatcher::Watch(watched_files(*g_spriteData));
+    }
+
     void HandleHotkeys(bool& isRunning) {
         Hotkeys::Action action = Hotkeys::Process();
         switch (action) {
@@ -167,6 +195,15 @@ namespace SpritePreviewer {
                 if (ImGui::MenuItem("Quit", "Ctrl+Q")) { isRunning = false; }
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("View")) {
+                bool profilerOpen = Profiler::IsEnabled();
+                if (ImGui::MenuItem("Profiler", nullptr, &profilerOpen)) Profiler::SetEnabled(profilerOpen);
+                if (ImGui::MenuItem("Record Trace", nullptr, Trace::IsRecording())) {
+                    if (!Trace::IsRecording()) Trace::Start();
+                    else if (Trace::Stop("trace.json", g_errorMessage)) g_successMessage = "Trace written to trace.json.";
+                }
+                ImGui::EndMenu();
+            }
             if (ImGui::BeginMenu("Help")) {
                 if (ImGui::MenuItem("Samster Birdies")) {
                     ShellExecuteA(NULL, "open", "https://www.samsterbirdies.com/tools/fortspivots", NULL, NULL, SW_SHOWNORMAL);
@@ -189,6 +226,9 @@ namespace SpritePreviewer {
         else if (!g_errorMessage.empty()) {
             ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", g_errorMessage.c_str());
         }
+        else if (TextureUpload::PendingCount() > 0) {
+            ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Streaming textures (%d remaining)...", (int)TextureUpload::PendingCount());
+        }
         else if (!g_successMessage.empty()) {
             ImGui::TextColored(ImVec4(0.2f, 1.0f, 0.2f, 1.0f), "%s", g_successMessage.c_str());
         }
@@ -197,9 +237,18 @@ namespace SpritePreviewer {
     }
 
     void RenderUI(bool& isRunning) {
+        Profiler::BeginFrame();
+        ProcessHotReload();
         RenderMenuBar(isRunning);
         HandleHotkeys(isRunning);
 
+        // The panels share plain pointers for the rest of the frame.
+        Node* selectedNode = g_spriteData ? Hierarchy::Resolve(*g_spriteData, g_selection) : nullptr;
+        Node* dragDropSource = nullptr;
+        Node* dragDropTarget = nullptr;
+        Node* nodeToDelete = nullptr;
+        Node* nodeToAddChildTo = nullptr;
+
         float menuBarHeight = ImGui::GetFrameHeight();
         float statusBarHeight = ImGui::GetFrameHeight();
         ImGui::SetNextWindowPos(ImVec2(0, menuBarHeight));
@@ -213,15 +262,24 @@ namespace SpritePreviewer {
         float viewWidth = ImGui::GetContentRegionAvail().x - leftPaneWidth - rightPaneWidth;
 
         ImGui::BeginChild("SpriteEditorPane", ImVec2(leftPaneWidth, 0), true);
-        SpriteEditor::Render(g_spriteData.get(), g_successMessage, g_errorMessage);
+        {
+            Profiler::Scope scope(Profiler::Section::SpriteEditor);
+            SpriteEditor::Render(g_spriteData.get(), g_successMessage, g_errorMessage);
+        }
         ImGui::EndChild();
 
         ImGui::SameLine();
 
         ImGui::BeginChild("CenterColumn", ImVec2(viewWidth, 0), false);
-        Timeline::Render(g_spriteData.get(), g_activeState, g_isPlaying, g_activeFrame, g_maxFrames, g_frameTimer);
+        {
+            Profiler::Scope scope(Profiler::Section::Timeline);
+            Timeline::Render(g_spriteData.get(), g_activeState, g_isPlaying, g_activeFrame, g_maxFrames, g_frameTimer);
+        }
         ImGui::BeginChild("SpriteViewPane", ImVec2(0, 0), true, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoMove);
-        Canvas::Render(g_spriteData ? g_spriteData->root.get() : nullptr, g_canvas, g_selectedNode, g_showPivots, g_activeState, g_spriteData ? g_spriteData->defaultState : "Normal", g_activeFrame);
+        {
+            Profiler::Scope scope(Profiler::Section::Canvas);
+            Canvas::Render(g_spriteData.get(), g_canvas, selectedNode, g_showPivots, g_activeState, g_activeFrame);
+        }
         ImGui::EndChild();
         ImGui::EndChild();
 
@@ -229,10 +287,16 @@ namespace SpritePreviewer {
 
         ImGui::BeginChild("RightColumn", ImVec2(rightPaneWidth, 0), false);
         ImGui::BeginChild("OutlinerPane", ImVec2(0, ImGui::GetContentRegionAvail().y * 0.4f), true);
-        Outliner::Render(g_spriteData ? g_spriteData->root.get() : nullptr, g_selectedNode, g_dragDropSourceNode, g_dragDropTargetNode, g_nodeToDelete, g_nodeToAddChildTo);
+        {
+            Profiler::Scope scope(Profiler::Section::Outliner);
+            Outliner::Render(g_spriteData.get(), selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo);
+        }
         ImGui::EndChild();
         ImGui::BeginChild("PropertiesPane", ImVec2(0, 0), true);
-        Editor::Render(g_spriteData.get(), g_selectedNode, g_showPivots);
+        {
+            Profiler::Scope scope(Profiler::Section::Editor);
+            Editor::Render(g_spriteData.get(), selectedNode, g_showPivots);
+        }
         ImGui::EndChild();
         ImGui::EndChild();
 
@@ -240,10 +304,20 @@ namespace SpritePreviewer {
         RenderStatusBar();
 
         UpdateAnimation();
-        Actions::Process(g_spriteData.get(), g_selectedNode, g_dragDropSourceNode, g_dragDropTargetNode, g_nodeToDelete, g_nodeToAddChildTo);
+        {
+            Profiler::Scope scope(Profiler::Section::Actions);
+            Actions::Process(g_spriteData.get(), selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo);
+        }
+        g_selection = g_spriteData ? Hierarchy::HandleOf(*g_spriteData, selectedNode) : NodeHandle();
+        Profiler::EndFrame();
+        Profiler::RenderWindow();
     }
 
     void Cleanup() {
-        if (g_spriteData) { for (auto const& [key, val] : g_spriteData->loadedTextures) { glDeleteTextures(1, &val); } }
+        FileWatcher::Stop();
+        Vfs::Shutdown();
+        if (g_spriteData) { TextureLoader::ReleaseTextures(*g_spriteData); }
+        TextureCache::Clear();
+        Profiler::Shutdown();
     }
 }
\ No newline at end of file
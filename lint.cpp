@@ -0,0 +1,151 @@
+#include "lint.h"
+#include "environment.h"
+#include "file_handling.h"
+#include "script_inputs.h"
+#include "thread_pool.h"
+#include "vfs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct FileResult {
+        bool skipped = false;
+        std::vector<std::string> issues;
+    };
+
+    // Follows link and NextState edges from start. A cycle whose states have
+    // no frames would spin forever; looping animations with frames are fine.
+    void check_state_cycle(const Sprite& sprite, const std::string& start, std::set<std::string>& reported, std::vector<std::string>& issues) {
+        std::vector<std::string> chain;
+        std::string current = start;
+        for (;;) {
+            auto loop = std::find(chain.begin(), chain.end(), current);
+            if (loop != chain.end()) {
+                std::vector<std::string> cycle(loop, chain.end());
+                bool has_frames = std::any_of(cycle.begin(), cycle.end(), [&](const std::string& name) { return !sprite.states.at(name).frames.empty(); });
+                std::string key = *std::min_element(cycle.begin(), cycle.end());
+                if (!has_frames && reported.insert(key).second) {
+                    std::string text;
+                    for (const auto& name : cycle) text += name + " -> ";
+                    issues.push_back("Sprite '" + sprite.name + "': state cycle without frames: " + text + current);
+                }
+                return;
+            }
+            auto it = sprite.states.find(current);
+            if (it == sprite.states.end()) return;
+            chain.push_back(current);
+            const SpriteState& state = it->second;
+            current = state.isLink ? state.linkToStateName : state.nextState;
+            if (current.empty()) return;
+        }
+    }
+
+    void check_nodes(const Node* node, const SpriteData& data, std::vector<std::string>& issues) {
+        if (!node) return;
+        if (!node->spriteName.empty() && !data.sprites.count(node->spriteName)) {
+            issues.push_back("Node '" + node->name + "' references missing sprite '" + node->spriteName + "'");
+        }
+        for (const auto& child : node->childrenBehind) check_nodes(child.get(), data, issues);
+        for (const auto& child : node->childrenInFront) check_nodes(child.get(), data, issues);
+    }
+
+    // Cheap pre-filter so plain Lua files (mod.lua, weapon configs) are never run.
+    bool looks_like_sprite_script(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return text.find("Sprites") != std::string::npos || text.find("Root") != std::string::npos;
+    }
+}
+
+void Lint::CheckSpriteData(const SpriteData& data, const std::vector<std::string>& searchPaths, std::vector<std::string>& issues) {
+    std::set<std::string> checked_textures;
+    for (const auto& [sprite_name, sprite] : data.sprites) {
+        if (!sprite.states.count(data.defaultState)) {
+            issues.push_back("Sprite '" + sprite_name + "' has no '" + data.defaultState + "' state");
+        }
+        std::set<std::string> reported_cycles;
+        for (const auto& [state_name, state] : sprite.states) {
+            if (state.isLink && !sprite.states.count(state.linkToStateName)) {
+                issues.push_back("Sprite '" + sprite_name + "': state '" + state_name + "' links to unknown state '" + state.linkToStateName + "'");
+            }
+            if (!state.nextState.empty() && !sprite.states.count(state.nextState)) {
+                issues.push_back("Sprite '" + sprite_name + "': state '" + state_name + "' has unknown NextState '" + state.nextState + "'");
+            }
+            check_state_cycle(sprite, state_name, reported_cycles, issues);
+            for (const auto& frame : state.frames) {
+                if (!checked_textures.insert(frame.texturePath).second) continue;
+                if (Vfs::Resolve(frame.texturePath, searchPaths, SUPPORTED_IMAGE_EXTENSIONS).empty()) {
+                    issues.push_back("Sprite '" + sprite_name + "': missing texture '" + frame.texturePath + "'");
+                }
+            }
+        }
+    }
+    check_nodes(data.root.get(), data, issues);
+}
+
+int Lint::Run(const std::vector<std::string>& args) {
+    std::vector<ScriptInputs::Input> inputs;
+    for (const auto& arg : args) {
+        std::string errorMessage;
+        if (!ScriptInputs::Expand(arg, inputs, errorMessage)) {
+            std::fprintf(stderr, "%s\n", errorMessage.c_str());
+            return 2;
+        }
+    }
+    if (inputs.empty()) {
+        std::printf("Usage: PivotHelper --lint <directory|script|glob|@list>...\n");
+        return 2;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::string> scripts(inputs.size());
+    std::set<std::string> roots;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        scripts[i] = std::filesystem::absolute(inputs[i].path).lexically_normal().string();
+        for (auto& root : Environment::SearchPathsForFile(scripts[i])) roots.insert(root);
+    }
+    Vfs::IndexNow(std::vector<std::string>(roots.begin(), roots.end()));
+
+    std::vector<FileResult> results(inputs.size());
+    ThreadPool::ParallelFor(inputs.size(), [&](size_t i) {
+        FileResult& result = results[i];
+        if (!looks_like_sprite_script(scripts[i])) {
+            result.skipped = true;
+            return;
+        }
+        std::vector<std::string> search_paths = Environment::SearchPathsForFile(scripts[i]);
+        SpriteData data;
+        std::string errorMessage;
+        if (!parse_sprite_file(scripts[i], search_paths, data, errorMessage, false)) {
+            result.issues.push_back(errorMessage);
+            return;
+        }
+        if (data.sprites.empty() && !data.root) {
+            result.skipped = true;
+            return;
+        }
+        Lint::CheckSpriteData(data, search_paths, result.issues);
+    });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t linted = 0, issue_count = 0, failing_files = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const FileResult& result = results[i];
+        if (result.skipped) continue;
+        ++linted;
+        if (result.issues.empty()) continue;
+        ++failing_files;
+        issue_count += result.issues.size();
+        for (const auto& issue : result.issues) std::printf("%s: %s\n", inputs[i].path.string().c_str(), issue.c_str());
+    }
+    std::printf("\nLinted %zu sprite scripts (%zu other files skipped) in %.2f s: %zu issues in %zu files\n",
+        linted, inputs.size() - linted, seconds, issue_count, failing_files);
+    return issue_count == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include "datatypes.h"
+#include <string>
+#include <vector>
+
+namespace Lint {
+    // Reports missing textures, sprites without a Normal state, dangling
+    // links, unknown NextState targets, link/NextState cycles that never reach
+    // a frame, and nodes naming sprites that do not exist. Textures are only
+    // resolved against searchPaths, never decoded.
+    void CheckSpriteData(const SpriteData& data, const std::vector<std::string>& searchPaths, std::vector<std::string>& issues);
+
+    // Headless lint of every sprite script below the given directories, globs
+    // or @list files: PivotHelper --lint <inputs>. Returns the exit code.
+    int Run(const std::vector<std::string>& args);
+}
\ No newline at end of file
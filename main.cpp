@@ -7,6 +7,12 @@
 #include <IL/ilu.h>
 #include "layout.h"
 #include "environment.h"
+#include "texture_upload.h"
+#include "batch_convert.h"
+#include "lint.h"
+#include "compositor.h"
+#include "benchmark.h"
+#include "trace.h"
 #include <iostream>
 
 #define NOMINMAX
@@ -16,9 +22,48 @@ void glfw_error_callback(int error, const char* description) {
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main(int, char**) {
+// "--trace <file>" may appear anywhere; it records the whole run.
+std::string take_trace_path(std::vector<std::string>& args) {
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] != "--trace") continue;
+        std::string path = args[i + 1];
+        args.erase(args.begin() + i, args.begin() + i + 2);
+        return path;
+    }
+    return "";
+}
+
+int finish_trace(const std::string& tracePath, int exitCode) {
+    std::string errorMessage;
+    if (!tracePath.empty() && !Trace::Stop(tracePath, errorMessage)) std::cerr << errorMessage << std::endl;
+    return exitCode;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    const std::string trace_path = take_trace_path(args);
+    if (!trace_path.empty()) Trace::Start();
+
     ilInit();
     iluInit();
+    const std::string mode = args.empty() ? "" : args[0];
+    const std::vector<std::string> mode_args(args.empty() ? args.end() : args.begin() + 1, args.end());
+    if (mode == "--convert") {
+        Environment::Initialize();
+        return finish_trace(trace_path, BatchConvert::Run(mode_args));
+    }
+    if (mode == "--lint") {
+        Environment::Initialize();
+        return finish_trace(trace_path, Lint::Run(mode_args));
+    }
+    if (mode == "--render") {
+        Environment::Initialize();
+        return finish_trace(trace_path, Compositor::Run(mode_args));
+    }
+    if (mode == "--benchmark") {
+        return finish_trace(trace_path, Benchmark::Run(mode_args));
+    }
+
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit()) return 1;
 
@@ -51,6 +96,7 @@ int main(int, char**) {
     bool isRunning = true;
     while (isRunning && !glfwWindowShouldClose(window)) {
         glfwPollEvents();
+        TextureUpload::Process(Environment::GetUploadBudgetMs());
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -72,6 +118,7 @@ int main(int, char**) {
     }
 
     SpritePreviewer::Cleanup();
+    TextureUpload::Shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -79,5 +126,5 @@ int main(int, char**) {
     glfwDestroyWindow(window);
     glfwTerminate();
 
-    return 0;
+    return finish_trace(trace_path, 0);
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "name_index.h"
+
+void Names::Index::Clear() {
+    m_counts.clear();
+    m_nextSuffix.clear();
+}
+
+void Names::Index::Add(const std::string& name) {
+    ++m_counts[name];
+}
+
+void Names::Index::Remove(const std::string& name) {
+    auto it = m_counts.find(name);
+    if (it == m_counts.end()) return;
+    if (--it->second == 0) m_counts.erase(it);
+}
+
+void Names::Index::Rename(const std::string& from, const std::string& to) {
+    if (from == to) return;
+    Remove(from);
+    Add(to);
+}
+
+bool Names::Index::Contains(const std::string& name) const {
+    return m_counts.count(name) != 0;
+}
+
+std::string Names::Index::Unique(const std::string& base) {
+    if (!Contains(base)) return base;
+    int& suffix = m_nextSuffix[base];
+    if (suffix == 0) suffix = 1;
+    std::string name = base + std::to_string(suffix);
+    while (Contains(name)) name = base + std::to_string(++suffix);
+    return name;
+}
\ No newline at end of file
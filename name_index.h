@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+namespace Names {
+    // Multiset of the names in one namespace (node names, sprite names, the
+    // states of one sprite), kept up to date on add, rename and delete so
+    // lookups and unique names do not walk the data.
+    class Index {
+    public:
+        void Clear();
+        void Add(const std::string& name);
+        void Remove(const std::string& name);
+        void Rename(const std::string& from, const std::string& to);
+        bool Contains(const std::string& name) const;
+        size_t size() const { return m_counts.size(); }
+
+        // base if it is free, otherwise base1, base2, ... Numbering resumes
+        // where the last call for base stopped, so numbers freed by a delete
+        // are not reused until the index is rebuilt. The name is not added.
+        std::string Unique(const std::string& base);
+
+    private:
+        std::unordered_map<std::string, int> m_counts;
+        std::unordered_map<std::string, int> m_nextSuffix;
+    };
+}
\ No newline at end of file
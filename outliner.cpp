@@ -1,25 +1,89 @@
 #include "outliner.h"
 #include "datatypes.h"
+#include "hierarchy.h"
+#include "theme.h"
 #include <imgui.h>
+#include <unordered_set>
+#include <vector>
 
 namespace {
-    void DrawNodeRecursive(Node* node, Node* root, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo, ImU32 dotColor = 0) {
-        if (!node) return;
+    struct Row {
+        Node* node;
+        NodeHandle handle;
+        int depth;
+        ImU32 dotColor;
+    };
 
-        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth;
-        if (selectedNode == node) flags |= ImGuiTreeNodeFlags_Selected;
-        if (node->childrenInFront.empty() && node->childrenBehind.empty()) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    struct HandleHash {
+        size_t operator()(const NodeHandle& handle) const {
+            return std::hash<std::uint64_t>()((std::uint64_t)handle.index << 32 | handle.generation);
+        }
+    };
+
+    // The visible rows in display order. Nodes start expanded, so only the
+    // collapsed ones are remembered, by handle so that a deleted node's
+    // state cannot carry over to a new node at the same address.
+    std::vector<Row> g_rows;
+    std::unordered_set<NodeHandle, HandleHash> g_collapsed;
+    const SpriteData* g_rowsData = nullptr;
+    const Node* g_rowsRoot = nullptr;
+    unsigned g_rowsVersion = 0;
+    bool g_rowsDirty = true;
+
+    bool IsLeaf(const Node* node) {
+        return node->childrenInFront.empty() && node->childrenBehind.empty();
+    }
+
+    void CollectRows(const SpriteData& spriteData, Node* node, int depth, ImU32 dotColor) {
+        NodeHandle handle = Hierarchy::HandleOf(spriteData, node);
+        g_rows.push_back({ node, handle, depth, dotColor });
+        if (IsLeaf(node) || g_collapsed.count(handle)) return;
+        for (const auto& child : node->childrenBehind) CollectRows(spriteData, child.get(), depth + 1, COLOR_HIERARCHY_BEHIND);
+        for (const auto& child : node->childrenInFront) CollectRows(spriteData, child.get(), depth + 1, COLOR_HIERARCHY_FRONT);
+    }
+
+    void UpdateRows(const SpriteData* spriteData, Node* root) {
+        if (root != g_rowsRoot || spriteData != g_rowsData) {
+            g_collapsed.clear();
+            g_rowsDirty = true;
+        }
+        if (!g_rowsDirty && spriteData->structureVersion == g_rowsVersion) return;
+        for (auto it = g_collapsed.begin(); it != g_collapsed.end();) {
+            if (Hierarchy::Resolve(*spriteData, *it)) ++it;
+            else it = g_collapsed.erase(it);
+        }
+        g_rows.clear();
+        CollectRows(*spriteData, root, 0, 0);
+        g_rowsData = spriteData;
+        g_rowsRoot = root;
+        g_rowsVersion = spriteData->structureVersion;
+        g_rowsDirty = false;
+    }
 
-        ImGui::SetNextItemOpen(true, ImGuiCond_Appearing);
+    void DrawRow(const SpriteData& spriteData, const Row& row, Node* root, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo) {
+        Node* node = row.node;
+        const bool leaf = IsLeaf(node);
 
-        if (dotColor != 0) {
+        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+        if (selectedNode == node) flags |= ImGuiTreeNodeFlags_Selected;
+        if (leaf) flags |= ImGuiTreeNodeFlags_Leaf;
+
+        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + row.depth * ImGui::GetStyle().IndentSpacing);
+        if (row.dotColor != 0) {
             ImVec2 p = ImGui::GetCursorScreenPos();
-            ImGui::GetWindowDrawList()->AddCircleFilled(ImVec2(p.x + 5, p.y + ImGui::GetTextLineHeight() * 0.5f), 3.5f, dotColor);
+            ImGui::GetWindowDrawList()->AddCircleFilled(ImVec2(p.x + 5, p.y + ImGui::GetTextLineHeight() * 0.5f), 3.5f, row.dotColor);
             ImGui::Dummy(ImVec2(14, 0));
             ImGui::SameLine();
         }
 
+        const bool collapsed = g_collapsed.count(row.handle) != 0;
+        if (!leaf) ImGui::SetNextItemOpen(!collapsed, ImGuiCond_Always);
         bool node_is_open = ImGui::TreeNodeEx((void*)(intptr_t)node, flags, "%s", node->name.c_str());
+        if (!leaf && node_is_open == collapsed) {
+            if (node_is_open) g_collapsed.erase(row.handle);
+            else g_collapsed.insert(row.handle);
+            g_rowsDirty = true;
+        }
 
         if (ImGui::IsItemClicked(ImGuiMouseButton_Left) || ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
             selectedNode = node;
@@ -36,42 +100,42 @@ namespace {
         ImGui::PopID();
 
         if (ImGui::BeginDragDropSource()) {
-            ImGui::SetDragDropPayload("NODE_DRAG_DROP", &node, sizeof(Node*));
+            // A handle rather than the pointer: the payload outlives the frame
+            // and the node may be deleted before it is dropped.
+            ImGui::SetDragDropPayload("NODE_DRAG_DROP", &row.handle, sizeof(NodeHandle));
             ImGui::Text("Move %s", node->name.c_str());
             ImGui::EndDragDropSource();
         }
 
         if (ImGui::BeginDragDropTarget()) {
             if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("NODE_DRAG_DROP")) {
-                IM_ASSERT(payload->DataSize == sizeof(Node*));
-                Node* payload_node = *(Node**)payload->Data;
-                if (payload_node != node) {
+                IM_ASSERT(payload->DataSize == sizeof(NodeHandle));
+                Node* payload_node = Hierarchy::Resolve(spriteData, *(const NodeHandle*)payload->Data);
+                if (payload_node && payload_node != node) {
                     dragDropSource = payload_node;
                     dragDropTarget = node;
                 }
             }
             ImGui::EndDragDropTarget();
         }
-
-        if (node_is_open && !(flags & ImGuiTreeNodeFlags_Leaf)) {
-            for (const auto& child : node->childrenBehind) {
-                DrawNodeRecursive(child.get(), root, selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo, COLOR_HIERARCHY_BEHIND);
-            }
-            for (const auto& child : node->childrenInFront) {
-                DrawNodeRecursive(child.get(), root, selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo, COLOR_HIERARCHY_FRONT);
-            }
-            ImGui::TreePop();
-        }
     }
 }
 
-void Outliner::Render(Node* root, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo) {
+void Outliner::Render(SpriteData* spriteData, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo) {
     ImGui::Text("Outliner");
     ImGui::Separator();
-    if (root) {
-        DrawNodeRecursive(root, root, selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo);
-    }
-    else {
+    Node* root = spriteData ? spriteData->root.get() : nullptr;
+    if (!root) {
         ImGui::Text("No data loaded.");
+        return;
+    }
+
+    UpdateRows(spriteData, root);
+    ImGuiListClipper clipper;
+    clipper.Begin((int)g_rows.size());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            DrawRow(*spriteData, g_rows[i], root, selectedNode, dragDropSource, dragDropTarget, nodeToDelete, nodeToAddChildTo);
+        }
     }
 }
\ No newline at end of file
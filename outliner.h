@@ -2,5 +2,7 @@
 #include "datatypes.h"
 
 namespace Outliner {
-    void Render(Node* root, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo);
+    // Only the rows in view are submitted; the flattened row list is rebuilt
+    // when a node is expanded or collapsed or the tree changes.
+    void Render(SpriteData* spriteData, Node*& selectedNode, Node*& dragDropSource, Node*& dragDropTarget, Node*& nodeToDelete, Node*& nodeToAddChildTo);
 }
\ No newline at end of file
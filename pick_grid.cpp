@@ -0,0 +1,155 @@
+#include "pick_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr int MAX_CELLS = 1 << 16;
+    constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+    float cross(const Vec2& a, const Vec2& b, const Vec2& p) {
+        return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+    }
+
+    bool boxes_overlap(const Vec2& min_a, const Vec2& max_a, const Vec2& min_b, const Vec2& max_b) {
+        return min_a.x <= max_b.x && min_b.x <= max_a.x && min_a.y <= max_b.y && min_b.y <= max_a.y;
+    }
+
+    bool box_contains(const Vec2& min, const Vec2& max, const Vec2& p) {
+        return p.x >= min.x && p.y >= min.y && p.x <= max.x && p.y <= max.y;
+    }
+}
+
+bool PickGrid::QuadContains(const Vec2 quad[4], const Vec2& point) {
+    bool positive = false, negative = false;
+    for (int i = 0; i < 4; ++i) {
+        float side = cross(quad[i], quad[(i + 1) % 4], point);
+        positive |= side > 0.0f;
+        negative |= side < 0.0f;
+    }
+    return !(positive && negative);
+}
+
+bool PickGrid::QuadOverlapsRect(const Vec2 quad[4], const Vec2& min, const Vec2& max) {
+    Vec2 quad_min = quad[0], quad_max = quad[0];
+    for (int i = 1; i < 4; ++i) {
+        quad_min = { std::min(quad_min.x, quad[i].x), std::min(quad_min.y, quad[i].y) };
+        quad_max = { std::max(quad_max.x, quad[i].x), std::max(quad_max.y, quad[i].y) };
+    }
+    if (!boxes_overlap(quad_min, quad_max, min, max)) return false;
+
+    // Separating axes left after the rectangle's own: the quad's edge normals.
+    const Vec2 rect[4] = { min, { max.x, min.y }, max, { min.x, max.y } };
+    for (int edge = 0; edge < 2; ++edge) {
+        Vec2 axis = { quad[edge].y - quad[edge + 1].y, quad[edge + 1].x - quad[edge].x };
+        float quad_lo = INFINITY, quad_hi = -INFINITY, rect_lo = INFINITY, rect_hi = -INFINITY;
+        for (int i = 0; i < 4; ++i) {
+            float q = quad[i].x * axis.x + quad[i].y * axis.y;
+            float r = rect[i].x * axis.x + rect[i].y * axis.y;
+            quad_lo = std::min(quad_lo, q); quad_hi = std::max(quad_hi, q);
+            rect_lo = std::min(rect_lo, r); rect_hi = std::max(rect_hi, r);
+        }
+        if (quad_hi < rect_lo || rect_hi < quad_lo) return false;
+    }
+    return true;
+}
+
+void PickGrid::Grid::Clear() {
+    m_items.clear();
+    m_cellStart.clear();
+    m_cellItems.clear();
+    m_columns = m_rows = 0;
+}
+
+void PickGrid::Grid::Add(int id, const Vec2 quad[4], const Vec2& min, const Vec2& max) {
+    if (!std::isfinite(min.x) || !std::isfinite(min.y) || !std::isfinite(max.x) || !std::isfinite(max.y)) return;
+    Item item{ id, { quad[0], quad[1], quad[2], quad[3] }, min, max };
+    m_items.push_back(item);
+}
+
+void PickGrid::Grid::CellRange(const Vec2& min, const Vec2& max, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = std::clamp((int)std::floor((min.x - m_origin.x) / m_cellSize), 0, m_columns - 1);
+    y0 = std::clamp((int)std::floor((min.y - m_origin.y) / m_cellSize), 0, m_rows - 1);
+    x1 = std::clamp((int)std::floor((max.x - m_origin.x) / m_cellSize), 0, m_columns - 1);
+    y1 = std::clamp((int)std::floor((max.y - m_origin.y) / m_cellSize), 0, m_rows - 1);
+}
+
+void PickGrid::Grid::Build() {
+    m_cellStart.clear();
+    m_cellItems.clear();
+    m_columns = m_rows = 0;
+    if (m_items.empty()) return;
+
+    // Cells about as large as an average quad keep most quads in at most four
+    // cells; the cell count stays proportional to the quad count.
+    Vec2 min = m_items[0].min, max = m_items[0].max;
+    double extent_sum = 0.0;
+    for (const Item& item : m_items) {
+        min = { std::min(min.x, item.min.x), std::min(min.y, item.min.y) };
+        max = { std::max(max.x, item.max.x), std::max(max.y, item.max.y) };
+        extent_sum += std::max(item.max.x - item.min.x, item.max.y - item.min.y);
+    }
+    const float width = std::max(max.x - min.x, 1e-3f);
+    const float height = std::max(max.y - min.y, 1e-3f);
+    const int max_cells = std::clamp((int)m_items.size() * 2, 1, MAX_CELLS);
+    m_cellSize = std::max({ (float)(extent_sum / m_items.size()), std::sqrt(width * height / max_cells), std::max(width, height) / MAX_CELLS_PER_AXIS, 1e-3f });
+    m_origin = min;
+    m_columns = std::max(1, (int)std::ceil(width / m_cellSize));
+    m_rows = std::max(1, (int)std::ceil(height / m_cellSize));
+
+    m_cellStart.assign((size_t)m_columns * m_rows + 1, 0);
+    int x0, y0, x1, y1;
+    for (const Item& item : m_items) {
+        CellRange(item.min, item.max, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) ++m_cellStart[(size_t)y * m_columns + x + 1];
+        }
+    }
+    for (size_t i = 1; i < m_cellStart.size(); ++i) m_cellStart[i] += m_cellStart[i - 1];
+
+    // Filling in item order keeps every cell sorted by draw order.
+    std::vector<int> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_cellItems.resize(m_cellStart.back());
+    for (int i = 0; i < (int)m_items.size(); ++i) {
+        CellRange(m_items[i].min, m_items[i].max, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) m_cellItems[cursor[(size_t)y * m_columns + x]++] = i;
+        }
+    }
+}
+
+int PickGrid::Grid::Pick(const Vec2& point, const std::function<bool(int id)>& accept) const {
+    if (m_columns == 0) return -1;
+    const Vec2 max = { m_origin.x + m_columns * m_cellSize, m_origin.y + m_rows * m_cellSize };
+    if (!box_contains(m_origin, max, point)) return -1;
+
+    int x, y, unused_x, unused_y;
+    CellRange(point, point, x, y, unused_x, unused_y);
+    const size_t cell = (size_t)y * m_columns + x;
+    for (int k = m_cellStart[cell + 1] - 1; k >= m_cellStart[cell]; --k) {
+        const Item& item = m_items[m_cellItems[k]];
+        if (!box_contains(item.min, item.max, point) || !QuadContains(item.quad, point)) continue;
+        if (!accept || accept(item.id)) return item.id;
+    }
+    return -1;
+}
+
+void PickGrid::Grid::Query(const Vec2& min, const Vec2& max, std::vector<int>& ids) const {
+    ids.clear();
+    if (m_columns == 0) return;
+
+    std::vector<int> hits;
+    int x0, y0, x1, y1;
+    CellRange(min, max, x0, y0, x1, y1);
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const size_t cell = (size_t)y * m_columns + x;
+            for (int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k) {
+                const Item& item = m_items[m_cellItems[k]];
+                if (boxes_overlap(item.min, item.max, min, max) && QuadOverlapsRect(item.quad, min, max)) hits.push_back(m_cellItems[k]);
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+    for (int index : hits) ids.push_back(m_items[index].id);
+}
\ No newline at end of file
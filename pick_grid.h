@@ -0,0 +1,42 @@
+#pragma once
+#include "datatypes.h"
+#include <functional>
+#include <vector>
+
+namespace PickGrid {
+    // Exact tests against a transformed quad given by its four corners in
+    // order; either winding works.
+    bool QuadContains(const Vec2 quad[4], const Vec2& point);
+    bool QuadOverlapsRect(const Vec2 quad[4], const Vec2& min, const Vec2& max);
+
+    // Uniform grid over the canvas quads in rig space. Quads are added in draw
+    // order, so a later one is drawn over an earlier one; Build must run after
+    // the last Add and before any query.
+    class Grid {
+    public:
+        void Clear();
+        void Add(int id, const Vec2 quad[4], const Vec2& min, const Vec2& max);
+        void Build();
+
+        // The id of the topmost quad under point, or -1. accept can reject a
+        // hit (e.g. a transparent texel) so the quad below is tried next.
+        int Pick(const Vec2& point, const std::function<bool(int id)>& accept = nullptr) const;
+        // Ids of every quad overlapping the rectangle, in draw order.
+        void Query(const Vec2& min, const Vec2& max, std::vector<int>& ids) const;
+
+        size_t size() const { return m_items.size(); }
+
+    private:
+        struct Item { int id; Vec2 quad[4]; Vec2 min, max; };
+
+        void CellRange(const Vec2& min, const Vec2& max, int& x0, int& y0, int& x1, int& y1) const;
+
+        std::vector<Item> m_items;
+        std::vector<int> m_cellStart;
+        std::vector<int> m_cellItems;
+        Vec2 m_origin;
+        float m_cellSize = 1.0f;
+        int m_columns = 0;
+        int m_rows = 0;
+    };
+}
\ No newline at end of file
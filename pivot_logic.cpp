@@ -1,66 +1,228 @@
 #include "pivot_logic.h"
 #include <cmath>
+#include <algorithm>
 
 #ifndef IM_PI
 #define IM_PI           3.14159265358979323846f
 #endif
 
 namespace {
-    ImVec2 rotate_point_around_origin(const ImVec2& point, float angle_rad) {
-        float s = sinf(angle_rad);
-        float c = cosf(angle_rad);
-        return ImVec2(point.x * c - point.y * s, point.x * s + point.y * c);
+    // A missing frame is treated as a zero-sized one, which collapses the pivot
+    // terms to the attachment point exactly like the frame-less branches did.
+    // The parent's linear part is read only from its matrix and its translation
+    // from position; angle_deg is carried along for display and never read, so
+    // a hand-built parent transform must fill in matrix, not just angle_deg.
+    Transform ComposeTransform(const Transform& parent_transform, const Vec2& pivot, const Vec2& parent_size, const Vec2& pivot_offset, const Vec2& my_size, float angle, float local_cos, float local_sin) {
+        const Affine2D& pm = parent_transform.matrix;
+
+        float pivot_x = pivot.x * parent_size.x;
+        float pivot_y = pivot.y * parent_size.y;
+        Vec2 attachment_point_world = {
+            parent_transform.position.x + pm.a * pivot_x + pm.c * pivot_y,
+            parent_transform.position.y + pm.b * pivot_x + pm.d * pivot_y
+        };
+
+        Transform result;
+        Affine2D& m = result.matrix;
+        m.a = pm.a * local_cos + pm.c * local_sin;
+        m.b = pm.b * local_cos + pm.d * local_sin;
+        m.c = pm.c * local_cos - pm.a * local_sin;
+        m.d = pm.d * local_cos - pm.b * local_sin;
+
+        float offset_x = pivot_offset.x * my_size.x;
+        float offset_y = pivot_offset.y * my_size.y;
+        m.tx = attachment_point_world.x + m.a * offset_x + m.c * offset_y;
+        m.ty = attachment_point_world.y + m.b * offset_x + m.d * offset_y;
+
+        result.position = { m.tx, m.ty };
+        result.angle_deg = parent_transform.angle_deg + angle;
+        result.anchor_pos = attachment_point_world;
+        return result;
     }
+
+    Vec2 FrameSize(const SpriteFrame* frame) {
+        return frame ? Vec2((float)frame->width, (float)frame->height) : Vec2(0.0f, 0.0f);
+    }
+
+    const SpriteFrame* FirstFrameOf(const Node* node, const std::string& stateName) {
+        if (!node->sprite_ptr) return nullptr;
+        auto state_it = node->sprite_ptr->states.find(stateName);
+        if (state_it == node->sprite_ptr->states.end() || state_it->second.frames.empty()) return nullptr;
+        return &state_it->second.frames[0];
+    }
+
+    std::vector<int> g_dirtyScratch;
+
+    struct RigCompiler {
+        PivotLogic::CompiledRig& rig;
+        const std::string& activeState;
+        const std::string& defaultState;
+        int activeFrame;
+
+        void Visit(Node* node, int parentIndex, const SpriteFrame* parent_frame) {
+            int index = (int)rig.nodes.size();
+            const SpriteFrame* frame_for_child = FirstFrameOf(node, defaultState);
+            node->rigIndex = index;
+            rig.nodes.push_back(node);
+            rig.sprite.push_back(node->sprite_ptr);
+            rig.parent.push_back(parentIndex);
+            rig.subtreeEnd.push_back(index + 1);
+            rig.pivot.push_back(node->pivot);
+            rig.pivotOffset.push_back(node->pivotOffset);
+            rig.angle.push_back(node->angle);
+            rig.localCos.push_back(0.0f);
+            rig.localSin.push_back(0.0f);
+            PivotLogic::UpdateLocalRotation(rig, index);
+            rig.parentFrame.push_back(parent_frame);
+            rig.ownFrame.push_back(frame_for_child);
+            rig.parentFrameSize.push_back(FrameSize(parent_frame));
+            rig.frameSize.push_back(FrameSize(frame_for_child));
+            rig.drawFrame.push_back(nullptr);
+
+            for (const auto& child : node->childrenBehind) {
+                Visit(child.get(), index, frame_for_child);
+            }
+
+            if (!node->sprite_ptr || node->sprite_ptr->states.empty()) {
+                for (const auto& child : node->childrenInFront) {
+                    Visit(child.get(), index, nullptr);
+                }
+                rig.subtreeEnd[index] = (int)rig.nodes.size();
+                return;
+            }
+
+            auto state_it = node->sprite_ptr->states.find(activeState);
+            bool useEffectiveState = (state_it != node->sprite_ptr->states.end() && !state_it->second.isLink);
+            if (!useEffectiveState) {
+                state_it = node->sprite_ptr->states.find(defaultState);
+            }
+            if (state_it == node->sprite_ptr->states.end() || state_it->second.frames.empty()) {
+                rig.subtreeEnd[index] = (int)rig.nodes.size();
+                return;
+            }
+
+            const auto& frames = state_it->second.frames;
+            int frameIndex = useEffectiveState ? std::min((int)frames.size() - 1, activeFrame) : 0;
+            const SpriteFrame& my_frame = frames[frameIndex];
+            if (my_frame.textureId == 0) {
+                rig.subtreeEnd[index] = (int)rig.nodes.size();
+                return;
+            }
+
+            rig.drawFrame[index] = &my_frame;
+            rig.drawOrder.push_back(index);
+
+            for (const auto& child : node->childrenInFront) {
+                Visit(child.get(), index, &my_frame);
+            }
+            rig.subtreeEnd[index] = (int)rig.nodes.size();
+        }
+    };
 }
 
 Transform PivotLogic::CalculateWorldTransform(
     const Node* node,
     const Transform& parent_transform,
-    const SpriteFrame* parent_frame,
-    const CanvasState& canvas)
+    const SpriteFrame* parent_frame)
 {
     if (!node) return parent_transform;
+    float angle_rad = node->angle * IM_PI / 180.0f;
+    return ComposeTransform(parent_transform, node->pivot, FrameSize(parent_frame), node->pivotOffset, FrameSize(FirstFrameOf(node, "Normal")), node->angle, cosf(angle_rad), sinf(angle_rad));
+}
 
-    float final_angle_deg = parent_transform.angle_deg + node->angle;
-    float final_angle_rad = final_angle_deg * IM_PI / 180.0f;
+void PivotLogic::CompileRig(Node* root, const std::string& activeState, const std::string& defaultState, int activeFrame, CompiledRig& rig) {
+    rig.nodes.clear();
+    rig.sprite.clear();
+    rig.parent.clear();
+    rig.subtreeEnd.clear();
+    rig.pivot.clear();
+    rig.pivotOffset.clear();
+    rig.angle.clear();
+    rig.localCos.clear();
+    rig.localSin.clear();
+    rig.parentFrame.clear();
+    rig.ownFrame.clear();
+    rig.parentFrameSize.clear();
+    rig.frameSize.clear();
+    rig.drawFrame.clear();
+    rig.drawOrder.clear();
+    if (!root) return;
 
-    ImVec2 attachment_point_world = parent_transform.position;
-    if (parent_frame) {
-        ImVec2 pivot_on_parent_local = {
-            node->pivot.x * parent_frame->width * canvas.zoom,
-            node->pivot.y * parent_frame->height * canvas.zoom
-        };
+    RigCompiler compiler{ rig, activeState, defaultState, activeFrame };
+    compiler.Visit(root, -1, nullptr);
+}
 
-        float parent_angle_rad = parent_transform.angle_deg * IM_PI / 180.0f;
-        ImVec2 pivot_on_parent_rotated = rotate_point_around_origin(pivot_on_parent_local, parent_angle_rad);
-        attachment_point_world.x += pivot_on_parent_rotated.x;
-        attachment_point_world.y += pivot_on_parent_rotated.y;
-    }
+void PivotLogic::UpdateLocalRotation(CompiledRig& rig, int index) {
+    float angle_rad = rig.angle[index] * IM_PI / 180.0f;
+    rig.localCos[index] = cosf(angle_rad);
+    rig.localSin[index] = sinf(angle_rad);
+}
 
-    const SpriteFrame* my_frame_ptr = nullptr;
-    if (node->sprite_ptr && !node->sprite_ptr->states.empty()) {
-        const auto& state_it = node->sprite_ptr->states.find("Normal");
-        if (state_it != node->sprite_ptr->states.end() && !state_it->second.frames.empty()) {
-            my_frame_ptr = &state_it->second.frames[0];
-        }
-    }
+void PivotLogic::EvaluatePose(const CompiledRig& rig, const Transform& root_transform, std::vector<Transform>& out_transforms) {
+    out_transforms.resize(rig.size());
+    EvaluatePoseRange(rig, root_transform, 0, (int)rig.size(), out_transforms);
+}
 
-    if (!my_frame_ptr) {
-        return { attachment_point_world, final_angle_deg, attachment_point_world };
+void PivotLogic::EvaluatePoseRange(const CompiledRig& rig, const Transform& root_transform, int begin, int end, std::vector<Transform>& transforms) {
+    for (int i = begin; i < end; ++i) {
+        int parent = rig.parent[i];
+        const Transform& parent_transform = parent < 0 ? root_transform : transforms[parent];
+        transforms[i] = ComposeTransform(parent_transform, rig.pivot[i], rig.parentFrameSize[i], rig.pivotOffset[i], rig.frameSize[i], rig.angle[i], rig.localCos[i], rig.localSin[i]);
     }
-    const SpriteFrame& my_frame = *my_frame_ptr;
+}
 
-    ImVec2 V_center_to_anchor_local = {
-        -node->pivotOffset.x * my_frame.width * canvas.zoom,
-        -node->pivotOffset.y * my_frame.height * canvas.zoom
-    };
+void PivotLogic::MarkNodeDirty(SpriteData* spriteData, Node* node) {
+    if (!spriteData || !node) return;
+    spriteData->dirtyNodes.push_back(node);
+}
 
-    ImVec2 V_center_to_anchor_rotated = rotate_point_around_origin(V_center_to_anchor_local, final_angle_rad);
+void PivotLogic::MarkSpriteDirty(SpriteData* spriteData, const Sprite* sprite) {
+    if (!spriteData || !sprite) return;
+    spriteData->dirtySprites.push_back(sprite);
+}
 
-    ImVec2 my_center_pos = {
-        attachment_point_world.x - V_center_to_anchor_rotated.x,
-        attachment_point_world.y - V_center_to_anchor_rotated.y
-    };
+void PivotLogic::MarkRigDirty(SpriteData* spriteData) {
+    if (!spriteData) return;
+    spriteData->rigDirty = true;
+    ++spriteData->structureVersion;
+}
+
+void PivotLogic::SyncDirtyNodes(CompiledRig& rig, SpriteData& spriteData, std::vector<std::pair<int, int>>& out_ranges) {
+    out_ranges.clear();
+    const int count = (int)rig.size();
+
+    std::vector<int>& roots = g_dirtyScratch;
+    roots.clear();
+    for (Node* node : spriteData.dirtyNodes) {
+        int index = node->rigIndex;
+        if (index < 0 || index >= count || rig.nodes[index] != node) continue;
+        rig.pivot[index] = node->pivot;
+        rig.pivotOffset[index] = node->pivotOffset;
+        if (rig.angle[index] != node->angle) {
+            rig.angle[index] = node->angle;
+            UpdateLocalRotation(rig, index);
+        }
+        roots.push_back(index);
+    }
+    if (!spriteData.dirtySprites.empty()) {
+        for (int i = 0; i < count; ++i) {
+            if (!rig.sprite[i]) continue;
+            if (std::find(spriteData.dirtySprites.begin(), spriteData.dirtySprites.end(), rig.sprite[i]) == spriteData.dirtySprites.end()) continue;
+            rig.frameSize[i] = FrameSize(rig.ownFrame[i]);
+            for (int child = i + 1; child < rig.subtreeEnd[i]; child = rig.subtreeEnd[child]) {
+                rig.parentFrameSize[child] = FrameSize(rig.parentFrame[child]);
+            }
+            roots.push_back(i);
+        }
+    }
+    spriteData.dirtyNodes.clear();
+    spriteData.dirtySprites.clear();
 
-    return { my_center_pos, final_angle_deg, attachment_point_world };
+    std::sort(roots.begin(), roots.end());
+    int covered_end = 0;
+    for (int index : roots) {
+        if (index < covered_end) continue;
+        covered_end = rig.subtreeEnd[index];
+        out_ranges.push_back({ index, covered_end });
+    }
 }
\ No newline at end of file
@@ -1,11 +1,63 @@
 #pragma once
 #include "datatypes.h"
+#include <string>
+#include <vector>
 
 namespace PivotLogic {
+    inline Vec2 TransformPoint(const Affine2D& m, const Vec2& p) {
+        return Vec2(m.a * p.x + m.c * p.y + m.tx, m.b * p.x + m.d * p.y + m.ty);
+    }
+
+    inline Affine2D MakeViewMatrix(const Vec2& origin, float zoom) {
+        Affine2D view;
+        view.a = zoom; view.d = zoom;
+        view.tx = origin.x; view.ty = origin.y;
+        return view;
+    }
+
+    // Flattened rig in pre-order: every parent precedes its children and each
+    // subtree occupies the contiguous range [i, subtreeEnd[i]).
+    struct CompiledRig {
+        std::vector<Node*> nodes;
+        std::vector<const Sprite*> sprite;
+        std::vector<int> parent;
+        std::vector<int> subtreeEnd;
+        std::vector<Vec2> pivot;
+        std::vector<Vec2> pivotOffset;
+        std::vector<float> angle;
+        std::vector<float> localCos;
+        std::vector<float> localSin;
+        std::vector<const SpriteFrame*> parentFrame;
+        std::vector<const SpriteFrame*> ownFrame;
+        std::vector<Vec2> parentFrameSize;
+        std::vector<Vec2> frameSize;
+        std::vector<const SpriteFrame*> drawFrame;
+        std::vector<int> drawOrder;
+
+        size_t size() const { return nodes.size(); }
+    };
+
+    // Poses are evaluated in rig space (texture pixels, root at the origin);
+    // pan and zoom are applied afterwards by a single view matrix.
     Transform CalculateWorldTransform(
         const Node* node,
         const Transform& parent_transform,
-        const SpriteFrame* parent_frame,
-        const CanvasState& canvas
+        const SpriteFrame* parent_frame
     );
+
+    void UpdateLocalRotation(CompiledRig& rig, int index);
+    void CompileRig(Node* root, const std::string& activeState, const std::string& defaultState, int activeFrame, CompiledRig& rig);
+    void EvaluatePose(const CompiledRig& rig, const Transform& root_transform, std::vector<Transform>& out_transforms);
+    void EvaluatePoseRange(const CompiledRig& rig, const Transform& root_transform, int begin, int end, std::vector<Transform>& transforms);
+
+    // Edits only record what changed; the canvas folds them into its compiled
+    // rig on the next frame. Structural edits (adding, deleting or moving
+    // nodes, changing sprites, states or frame lists) need a full recompile.
+    void MarkNodeDirty(SpriteData* spriteData, Node* node);
+    void MarkSpriteDirty(SpriteData* spriteData, const Sprite* sprite);
+    void MarkRigDirty(SpriteData* spriteData);
+
+    // Copies edited values into the rig and returns the merged subtree ranges
+    // whose transforms must be re-evaluated.
+    void SyncDirtyNodes(CompiledRig& rig, SpriteData& spriteData, std::vector<std::pair<int, int>>& out_ranges);
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "profiler.h"
+#include <GL/glew.h>
+#include <imgui.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace {
+    constexpr int HISTORY = 240;
+    // GPU results arrive a few frames late; each in-flight frame owns a pair.
+    constexpr int QUERY_FRAMES = 4;
+    constexpr int SECTION_COUNT = (int)Profiler::Section::Count;
+    constexpr int COUNTER_COUNT = (int)Profiler::Counter::Count;
+    const char* SECTION_NAMES[SECTION_COUNT] = { "RenderUI", "SpriteEditor", "Timeline", "Canvas", "Outliner", "Editor", "Actions::Process" };
+    const char* COUNTER_NAMES[COUNTER_COUNT] = { "Nodes traversed", "Quads emitted", "Draw commands", "Texture binds" };
+
+    // Fixed-size ring of per-frame samples.
+    struct History {
+        std::array<float, HISTORY> values{};
+        int next = 0;
+        int count = 0;
+
+        void Push(float value) {
+            values[next] = value;
+            next = (next + 1) % HISTORY;
+            count = std::min(count + 1, HISTORY);
+        }
+
+        float Last() const { return count ? values[(next + HISTORY - 1) % HISTORY] : 0.0f; }
+
+        void Stats(float& min, float& avg, float& p99) const {
+            min = avg = p99 = 0.0f;
+            if (!count) return;
+            std::vector<float> sorted(values.begin(), values.begin() + count);
+            std::sort(sorted.begin(), sorted.end());
+            min = sorted.front();
+            for (float v : sorted) avg += v;
+            avg /= count;
+            p99 = sorted[std::min(count - 1, (int)(count * 0.99f))];
+        }
+    };
+
+    struct GpuQueries {
+        GLuint begin = 0, end = 0;
+        bool issued = false;
+    };
+
+    bool g_enabled = false;
+    bool g_inFrame = false;
+    std::chrono::steady_clock::time_point g_frameStart;
+    std::array<double, SECTION_COUNT> g_times{};
+    std::array<int, COUNTER_COUNT> g_counts{};
+    std::array<History, SECTION_COUNT> g_timeHistory;
+    std::array<History, COUNTER_COUNT> g_countHistory;
+    History g_gpuHistory;
+    std::array<GpuQueries, QUERY_FRAMES> g_queries;
+    int g_queryFrame = 0;
+    bool g_queriesCreated = false;
+
+    void stamp(const ImDrawList*, const ImDrawCmd* cmd) {
+        glQueryCounter((GLuint)(uintptr_t)cmd->UserCallbackData, GL_TIMESTAMP);
+    }
+
+    void collect_gpu_results() {
+        for (auto& queries : g_queries) {
+            if (!queries.issued) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries.end, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+            GLuint64 begin_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(queries.begin, GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(queries.end, GL_QUERY_RESULT, &end_ns);
+            g_gpuHistory.Push((float)((end_ns - begin_ns) / 1e6));
+            queries.issued = false;
+        }
+    }
+
+    void stats_row(const char* name, const History& history, const char* format) {
+        float min, avg, p99;
+        history.Stats(min, avg, p99);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn(); ImGui::Text(format, history.Last());
+        ImGui::TableNextColumn(); ImGui::Text(format, min);
+        ImGui::TableNextColumn(); ImGui::Text(format, avg);
+        ImGui::TableNextColumn(); ImGui::Text(format, p99);
+    }
+}
+
+bool Profiler::IsEnabled() {
+    return g_enabled;
+}
+
+void Profiler::SetEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+void Profiler::BeginFrame() {
+    g_inFrame = g_enabled;
+    if (!g_inFrame) return;
+    g_frameStart = std::chrono::steady_clock::now();
+    g_times.fill(0.0);
+    g_counts.fill(0);
+    if (g_queriesCreated) collect_gpu_results();
+}
+
+void Profiler::EndFrame() {
+    if (!g_inFrame) return;
+    g_inFrame = false;
+    g_times[(int)Section::Frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_frameStart).count();
+    for (int i = 0; i < SECTION_COUNT; ++i) g_timeHistory[i].Push((float)g_times[i]);
+    for (int i = 0; i < COUNTER_COUNT; ++i) g_countHistory[i].Push((float)g_counts[i]);
+}
+
+void Profiler::AddTime(Section section, double ms) {
+    if (g_inFrame) g_times[(int)section] += ms;
+}
+
+void Profiler::AddCount(Counter counter, int amount) {
+    if (g_inFrame) g_counts[(int)counter] += amount;
+}
+
+void Profiler::BeginGpuCanvas(ImDrawList* drawList) {
+    if (!g_inFrame) return;
+    if (!g_queriesCreated) {
+        for (auto& queries : g_queries) {
+            glGenQueries(1, &queries.begin);
+            glGenQueries(1, &queries.end);
+        }
+        g_queriesCreated = true;
+    }
+    // A slot whose results never came back is reused rather than stalling.
+    GpuQueries& queries = g_queries[g_queryFrame];
+    queries.issued = false;
+    drawList->AddCallback(stamp, (void*)(uintptr_t)queries.begin);
+}
+
+void Profiler::EndGpuCanvas(ImDrawList* drawList) {
+    if (!g_inFrame || !g_queriesCreated) return;
+    GpuQueries& queries = g_queries[g_queryFrame];
+    drawList->AddCallback(stamp, (void*)(uintptr_t)queries.end);
+    queries.issued = true;
+    g_queryFrame = (g_queryFrame + 1) % QUERY_FRAMES;
+}
+
+void Profiler::RenderWindow() {
+    if (!g_enabled) return;
+    ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", &g_enabled)) {
+        ImGui::End();
+        return;
+    }
+
+    const History& frame = g_timeHistory[(int)Section::Frame];
+    std::array<float, HISTORY> ordered{};
+    for (int i = 0; i < frame.count; ++i) ordered[i] = frame.values[(frame.next - frame.count + i + HISTORY) % HISTORY];
+    ImGui::PlotLines("##FrameTimes", ordered.data(), frame.count, 0, "RenderUI ms", 0.0f, 33.0f, ImVec2(ImGui::GetContentRegionAvail().x, 60));
+
+    if (ImGui::BeginTable("Timings", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("last");
+        ImGui::TableSetupColumn("min");
+        ImGui::TableSetupColumn("avg");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < SECTION_COUNT; ++i) stats_row(SECTION_NAMES[i], g_timeHistory[i], "%.3f");
+        stats_row("Canvas (GPU)", g_gpuHistory, "%.3f");
+        ImGui::EndTable();
+    }
+    if (ImGui::BeginTable("Counters", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("per frame");
+        ImGui::TableSetupColumn("last");
+        ImGui::TableSetupColumn("min");
+        ImGui::TableSetupColumn("avg");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < COUNTER_COUNT; ++i) stats_row(COUNTER_NAMES[i], g_countHistory[i], "%.0f");
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void Profiler::Shutdown() {
+    if (!g_queriesCreated) return;
+    for (auto& queries : g_queries) {
+        glDeleteQueries(1, &queries.begin);
+        glDeleteQueries(1, &queries.end);
+    }
+    g_queriesCreated = false;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+
+struct ImDrawList;
+
+namespace Profiler {
+    enum class Section { Frame, SpriteEditor, Timeline, Canvas, Outliner, Editor, Actions, Count };
+    enum class Counter { NodesTraversed, QuadsEmitted, DrawCommands, TextureBinds, Count };
+
+    // Nothing is recorded while the profiler window is closed.
+    bool IsEnabled();
+    void SetEnabled(bool enabled);
+
+    // Section::Frame covers everything between these two calls.
+    void BeginFrame();
+    void EndFrame();
+    void AddTime(Section section, double ms);
+    void AddCount(Counter counter, int amount);
+
+    // Bracket canvas drawing in its draw list; the commands in between are
+    // timed on the GPU with timestamp queries when the list is rendered.
+    void BeginGpuCanvas(ImDrawList* drawList);
+    void EndGpuCanvas(ImDrawList* drawList);
+
+    void RenderWindow();
+    void Shutdown();
+
+    class Scope {
+    public:
+        explicit Scope(Section section) : m_section(section), m_start(std::chrono::steady_clock::now()) {}
+        ~Scope() { AddTime(m_section, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count()); }
+    private:
+        Section m_section;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "project_loader.h"
+#include "file_handling.h"
+#include "texture_loader.h"
+#include "pivot_logic.h"
+
+void load_sprite_file(
+    const std::string& script_relative_path,
+    std::unique_ptr<SpriteData>& spriteData,
+    std::string& errorMessage,
+    std::string& successMessage,
+    CanvasState& canvas) {
+
+    errorMessage.clear();
+    successMessage.clear();
+
+    auto data = std::make_unique<SpriteData>();
+    if (!parse_sprite_file(script_relative_path, *data, errorMessage)) return;
+
+    TextureLoader::LoadSpriteTextures(*data, errorMessage);
+    if (!errorMessage.empty()) {
+        TextureLoader::ReleaseTextures(*data);
+        return;
+    }
+
+    size_t totalStates = 0;
+    for (const auto& pair : data->sprites) {
+        totalStates += pair.second.states.size();
+    }
+    successMessage = "Loaded " + std::to_string(data->sprites.size()) + " sprites with " + std::to_string(totalStates) + " total states successfully!";
+    canvas.pan = { 0.0f, 0.0f };
+    canvas.zoom = 1.0f;
+    // Released only now, so textures shared with the new file stay resident.
+    if (spriteData) {
+        TextureLoader::ReleaseTextures(*spriteData);
+    }
+    spriteData = std::move(data);
+}
+
+void reload_sprite_file(
+    const std::set<std::string>& changedFiles,
+    SpriteData& spriteData,
+    Node*& selectedNode,
+    std::string& errorMessage,
+    std::string& successMessage) {
+
+    errorMessage.clear();
+    successMessage.clear();
+    TextureLoader::ReloadTextures(spriteData, changedFiles, errorMessage);
+    PivotLogic::MarkRigDirty(&spriteData);
+    if (!changedFiles.count(spriteData.scriptFile)) {
+        if (errorMessage.empty()) successMessage = "Reloaded " + std::to_string(changedFiles.size()) + " changed texture(s).";
+        return;
+    }
+
+    SpriteData fresh;
+    if (!parse_sprite_file(spriteData.scriptPath, fresh, errorMessage)) return;
+
+    bool tree_changed = false;
+    int changed_sprites = merge_sprite_data(spriteData, fresh, selectedNode, tree_changed);
+
+    TextureLoader::LoadSpriteTextures(spriteData, errorMessage);
+    if (errorMessage.empty()) {
+        successMessage = "Reloaded script: " + std::to_string(changed_sprites) + " sprite(s) changed" + (tree_changed ? ", hierarchy updated." : ".");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "datatypes.h"
+#include <string>
+#include <memory>
+#include <set>
+
+void load_sprite_file(
+    const std::string& script_relative_path,
+    std::unique_ptr<SpriteData>& spriteData,
+    std::string& errorMessage,
+    std::string& successMessage,
+    CanvasState& canvas
+);
+
+// Applies on-disk changes in place: changed textures are re-decoded into their
+// existing slots and, if the script changed, it is re-run and merged so that
+// unchanged sprites, textures and the node tree survive.
+void reload_sprite_file(
+    const std::set<std::string>& changedFiles,
+    SpriteData& spriteData,
+    Node*& selectedNode,
+    std::string& errorMessage,
+    std::string& successMessage
+);
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "quad_batch.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define QUAD_BATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define QUAD_BATCH_TARGET_AVX2
+#define QUAD_BATCH_TARGET_SSE2
+#else
+#define QUAD_BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#define QUAD_BATCH_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+#ifndef IM_PI
+#define IM_PI           3.14159265358979323846f
+#endif
+
+namespace {
+    struct Views {
+        const float* cx; const float* cy;
+        const float* hw; const float* hh;
+        const float* axx; const float* axy; const float* ayx; const float* ayy;
+        float* px[4]; float* py[4];
+        float* minX; float* minY; float* maxX; float* maxY;
+    };
+
+    Views MakeViews(QuadBatch::Batch& b) {
+        Views v;
+        v.cx = b.centerX.data(); v.cy = b.centerY.data();
+        v.hw = b.halfWidth.data(); v.hh = b.halfHeight.data();
+        v.axx = b.axisXx.data(); v.axy = b.axisXy.data(); v.ayx = b.axisYx.data(); v.ayy = b.axisYy.data();
+        for (int k = 0; k < 4; ++k) { v.px[k] = b.cornerX[k].data(); v.py[k] = b.cornerY[k].data(); }
+        v.minX = b.minX.data(); v.minY = b.minY.data(); v.maxX = b.maxX.data(); v.maxY = b.maxY.data();
+        return v;
+    }
+
+    // Half-axis vectors ex = M * (hw, 0) and ey = M * (0, hh). The corners are
+    // center -/+ ex -/+ ey and the bounds extend |ex| + |ey| on each axis.
+    void ComputeScalar(const Views& v, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float exx = v.hw[i] * v.axx[i], exy = v.hw[i] * v.axy[i];
+            float eyx = v.hh[i] * v.ayx[i], eyy = v.hh[i] * v.ayy[i];
+            v.px[0][i] = v.cx[i] - exx - eyx; v.py[0][i] = v.cy[i] - exy - eyy;
+            v.px[1][i] = v.cx[i] + exx - eyx; v.py[1][i] = v.cy[i] + exy - eyy;
+            v.px[2][i] = v.cx[i] + exx + eyx; v.py[2][i] = v.cy[i] + exy + eyy;
+            v.px[3][i] = v.cx[i] - exx + eyx; v.py[3][i] = v.cy[i] - exy + eyy;
+            float extX = std::fabs(exx) + std::fabs(eyx);
+            float extY = std::fabs(exy) + std::fabs(eyy);
+            v.minX[i] = v.cx[i] - extX; v.maxX[i] = v.cx[i] + extX;
+            v.minY[i] = v.cy[i] - extY; v.maxY[i] = v.cy[i] + extY;
+        }
+    }
+
+#ifdef QUAD_BATCH_X86
+    QUAD_BATCH_TARGET_SSE2 size_t ComputeSSE2(const Views& v, size_t count) {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 cx = _mm_loadu_ps(v.cx + i), cy = _mm_loadu_ps(v.cy + i);
+            __m128 hw = _mm_loadu_ps(v.hw + i), hh = _mm_loadu_ps(v.hh + i);
+            __m128 exx = _mm_mul_ps(hw, _mm_loadu_ps(v.axx + i)), exy = _mm_mul_ps(hw, _mm_loadu_ps(v.axy + i));
+            __m128 eyx = _mm_mul_ps(hh, _mm_loadu_ps(v.ayx + i)), eyy = _mm_mul_ps(hh, _mm_loadu_ps(v.ayy + i));
+            __m128 ax = _mm_sub_ps(cx, exx), bx = _mm_add_ps(cx, exx);
+            __m128 ay = _mm_sub_ps(cy, exy), by = _mm_add_ps(cy, exy);
+            _mm_storeu_ps(v.px[0] + i, _mm_sub_ps(ax, eyx)); _mm_storeu_ps(v.py[0] + i, _mm_sub_ps(ay, eyy));
+            _mm_storeu_ps(v.px[1] + i, _mm_sub_ps(bx, eyx)); _mm_storeu_ps(v.py[1] + i, _mm_sub_ps(by, eyy));
+            _mm_storeu_ps(v.px[2] + i, _mm_add_ps(bx, eyx)); _mm_storeu_ps(v.py[2] + i, _mm_add_ps(by, eyy));
+            _mm_storeu_ps(v.px[3] + i, _mm_add_ps(ax, eyx)); _mm_storeu_ps(v.py[3] + i, _mm_add_ps(ay, eyy));
+            __m128 extX = _mm_add_ps(_mm_andnot_ps(sign, exx), _mm_andnot_ps(sign, eyx));
+            __m128 extY = _mm_add_ps(_mm_andnot_ps(sign, exy), _mm_andnot_ps(sign, eyy));
+            _mm_storeu_ps(v.minX + i, _mm_sub_ps(cx, extX)); _mm_storeu_ps(v.maxX + i, _mm_add_ps(cx, extX));
+            _mm_storeu_ps(v.minY + i, _mm_sub_ps(cy, extY)); _mm_storeu_ps(v.maxY + i, _mm_add_ps(cy, extY));
+        }
+        return i;
+    }
+
+    QUAD_BATCH_TARGET_AVX2 size_t ComputeAVX2(const Views& v, size_t count) {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 cx = _mm256_loadu_ps(v.cx + i), cy = _mm256_loadu_ps(v.cy + i);
+            __m256 hw = _mm256_loadu_ps(v.hw + i), hh = _mm256_loadu_ps(v.hh + i);
+            __m256 exx = _mm256_mul_ps(hw, _mm256_loadu_ps(v.axx + i)), exy = _mm256_mul_ps(hw, _mm256_loadu_ps(v.axy + i));
+            __m256 eyx = _mm256_mul_ps(hh, _mm256_loadu_ps(v.ayx + i)), eyy = _mm256_mul_ps(hh, _mm256_loadu_ps(v.ayy + i));
+            __m256 ax = _mm256_sub_ps(cx, exx), bx = _mm256_add_ps(cx, exx);
+            __m256 ay = _mm256_sub_ps(cy, exy), by = _mm256_add_ps(cy, exy);
+            _mm256_storeu_ps(v.px[0] + i, _mm256_sub_ps(ax, eyx)); _mm256_storeu_ps(v.py[0] + i, _mm256_sub_ps(ay, eyy));
+            _mm256_storeu_ps(v.px[1] + i, _mm256_sub_ps(bx, eyx)); _mm256_storeu_ps(v.py[1] + i, _mm256_sub_ps(by, eyy));
+            _mm256_storeu_ps(v.px[2] + i, _mm256_add_ps(bx, eyx)); _mm256_storeu_ps(v.py[2] + i, _mm256_add_ps(by, eyy));
+            _mm256_storeu_ps(v.px[3] + i, _mm256_add_ps(ax, eyx)); _mm256_storeu_ps(v.py[3] + i, _mm256_add_ps(ay, eyy));
+            __m256 extX = _mm256_add_ps(_mm256_andnot_ps(sign, exx), _mm256_andnot_ps(sign, eyx));
+            __m256 extY = _mm256_add_ps(_mm256_andnot_ps(sign, exy), _mm256_andnot_ps(sign, eyy));
+            _mm256_storeu_ps(v.minX + i, _mm256_sub_ps(cx, extX)); _mm256_storeu_ps(v.maxX + i, _mm256_add_ps(cx, extX));
+            _mm256_storeu_ps(v.minY + i, _mm256_sub_ps(cy, extY)); _mm256_storeu_ps(v.maxY + i, _mm256_add_ps(cy, extY));
+        }
+        return i;
+    }
+
+    QuadBatch::Backend DetectBackend() {
+#ifdef _MSC_VER
+        int info[4] = { 0 };
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse2 = __builtin_cpu_supports("sse2");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2) return QuadBatch::Backend::AVX2;
+        if (sse2) return QuadBatch::Backend::SSE2;
+        return QuadBatch::Backend::Scalar;
+    }
+#else
+    QuadBatch::Backend DetectBackend() {
+        return QuadBatch::Backend::Scalar;
+    }
+#endif
+}
+
+void QuadBatch::Batch::Resize(size_t count) {
+    centerX.resize(count); centerY.resize(count);
+    halfWidth.resize(count); halfHeight.resize(count);
+    axisXx.resize(count); axisXy.resize(count); axisYx.resize(count); axisYy.resize(count);
+    angleDeg.resize(count);
+    for (int k = 0; k < 4; ++k) { cornerX[k].resize(count); cornerY[k].resize(count); }
+    minX.resize(count); minY.resize(count); maxX.resize(count); maxY.resize(count);
+}
+
+QuadBatch::Backend QuadBatch::ActiveBackend() {
+    static const Backend backend = DetectBackend();
+    return backend;
+}
+
+const char* QuadBatch::BackendName(Backend backend) {
+    switch (backend) {
+    case Backend::AVX2: return "AVX2";
+    case Backend::SSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+void QuadBatch::ComputeFromAngles(Batch& batch) {
+    const size_t count = batch.size();
+    for (size_t i = 0; i < count; ++i) {
+        float angle_rad = batch.angleDeg[i] * IM_PI / 180.0f;
+        float c = cosf(angle_rad), s = sinf(angle_rad);
+        batch.axisXx[i] = c; batch.axisXy[i] = s;
+        batch.axisYx[i] = -s; batch.axisYy[i] = c;
+    }
+    Compute(batch);
+}
+
+void QuadBatch::Compute(Batch& batch) {
+    const size_t count = batch.size();
+    Views views = MakeViews(batch);
+    size_t done = 0;
+#ifdef QUAD_BATCH_X86
+    switch (ActiveBackend()) {
+    case Backend::AVX2: done = ComputeAVX2(views, count); break;
+    case Backend::SSE2: done = ComputeSSE2(views, count); break;
+    default: break;
+    }
+#endif
+    ComputeScalar(views, done, count);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+namespace QuadBatch {
+    enum class Backend { Scalar, SSE2, AVX2 };
+
+    // Structure-of-arrays batch of transformed quads. Inputs are the quad
+    // centers, half extents and the linear part of each quad's affine matrix
+    // (its x and y axis columns); Compute fills the four corners (top-left,
+    // top-right, bottom-right, bottom-left before transformation) and the
+    // axis-aligned bounds of every quad. ComputeFromAngles derives pure
+    // rotation axes from angleDeg first.
+    struct Batch {
+        std::vector<float> centerX, centerY;
+        std::vector<float> halfWidth, halfHeight;
+        std::vector<float> axisXx, axisXy, axisYx, axisYy;
+        std::vector<float> angleDeg;
+
+        std::vector<float> cornerX[4], cornerY[4];
+        std::vector<float> minX, minY, maxX, maxY;
+
+        void Resize(size_t count);
+        size_t size() const { return centerX.size(); }
+    };
+
+    Backend ActiveBackend();
+    const char* BackendName(Backend backend);
+    void Compute(Batch& batch);
+    void ComputeFromAngles(Batch& batch);
+}
\ No newline at end of file
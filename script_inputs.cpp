@@ -0,0 +1,83 @@
+#include "script_inputs.h"
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+namespace {
+    bool has_wildcard(const std::string& text) {
+        return text.find_first_of("*?") != std::string::npos;
+    }
+
+    // '*' and '?' stay within one path component, '**' also crosses '/'.
+    bool wildcard_match(const char* pattern, const char* text) {
+        for (; *pattern; ++pattern, ++text) {
+            if (*pattern == '*') {
+                bool any_depth = pattern[1] == '*';
+                pattern += any_depth ? 2 : 1;
+                if (any_depth && *pattern == '/') {
+                    if (wildcard_match(pattern + 1, text)) return true;
+                }
+                for (;; ++text) {
+                    if (wildcard_match(pattern, text)) return true;
+                    if (!*text || (!any_depth && *text == '/')) return false;
+                }
+            }
+            if (!*text || (*pattern != '?' && *pattern != *text) || (*pattern == '?' && *text == '/')) return false;
+        }
+        return !*text;
+    }
+
+    void expand_glob(const std::string& pattern, std::vector<ScriptInputs::Input>& inputs) {
+        std::string generic = std::filesystem::path(pattern).generic_string();
+        size_t wildcard = generic.find_first_of("*?");
+        size_t split = generic.rfind('/', wildcard);
+        std::filesystem::path base = split == std::string::npos ? "." : generic.substr(0, split + 1);
+        std::string rest = split == std::string::npos ? generic : generic.substr(split + 1);
+        bool recursive = rest.find('/') != std::string::npos || rest.find("**") != std::string::npos;
+
+        std::vector<std::filesystem::path> matches;
+        std::error_code ec;
+        auto consider = [&](const std::filesystem::directory_entry& entry) {
+            if (!entry.is_regular_file(ec)) return;
+            std::string relative = entry.path().lexically_relative(base).generic_string();
+            if (wildcard_match(rest.c_str(), relative.c_str())) matches.push_back(entry.path());
+        };
+        if (recursive) {
+            for (auto it = std::filesystem::recursive_directory_iterator(base, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) consider(*it);
+        }
+        else {
+            for (auto it = std::filesystem::directory_iterator(base, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) consider(*it);
+        }
+        std::sort(matches.begin(), matches.end());
+        for (auto& match : matches) inputs.push_back({ match, base });
+    }
+}
+
+bool ScriptInputs::Expand(const std::string& arg, std::vector<Input>& inputs, std::string& errorMessage) {
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream list(arg.substr(1));
+        if (!list.is_open()) {
+            errorMessage = "Could not open list file " + arg.substr(1);
+            return false;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            if (!Expand(line, inputs, errorMessage)) return false;
+        }
+        return true;
+    }
+    if (has_wildcard(arg)) {
+        expand_glob(arg, inputs);
+        return true;
+    }
+    std::filesystem::path path(arg);
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        expand_glob((path / "**" / "*.lua").generic_string(), inputs);
+        return true;
+    }
+    inputs.push_back({ path, path.parent_path() });
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ScriptInputs {
+    struct Input {
+        std::filesystem::path path;
+        std::filesystem::path base; // outputs keep the path relative to this
+    };
+
+    // Expands one command-line input: a script path, a directory (every .lua
+    // below it), a glob ('*' and '?' within a component, '**' across them) or
+    // an @list file with one input per line.
+    bool Expand(const std::string& arg, std::vector<Input>& inputs, std::string& errorMessage);
+}
\ No newline at end of file
@@ -1,20 +1,45 @@
 #include "sprite_editor.h"
 #include "texture_loader.h"
+#include "pivot_logic.h"
 #include <imgui.h>
 #include <string>
 #include <vector>
-#include <set>
-#include <GL/glew.h>
 
 namespace {
-    std::string GenerateUniqueName(const std::string& base, const std::set<std::string>& existingNames) {
-        if (existingNames.find(base) == existingNames.end()) return base;
-        int i = 1;
-        while (true) {
-            std::string newName = base + std::to_string(i);
-            if (existingNames.find(newName) == existingNames.end()) return newName;
-            i++;
+    // Names shown by the open combo, captured when its popup appears so the
+    // rows can be clipped while it stays open. Only one combo is open at a time.
+    std::vector<std::string> g_comboItems;
+
+    // Draws the keys of items as selectables inside BeginCombo/EndCombo,
+    // submitting only the visible rows. Returns true when one was picked.
+    template <typename Map>
+    bool ClippedComboItems(const Map& items, std::string& selected, const std::string& skip = "") {
+        if (ImGui::IsWindowAppearing()) {
+            g_comboItems.clear();
+            int selected_index = -1;
+            for (const auto& pair : items) {
+                if (pair.first == skip) continue;
+                if (pair.first == selected) selected_index = (int)g_comboItems.size();
+                g_comboItems.push_back(pair.first);
+            }
+            if (selected_index > 0) ImGui::SetScrollY(ImGui::GetCursorPosY() + selected_index * ImGui::GetTextLineHeightWithSpacing());
         }
+
+        bool picked = false;
+        ImGuiListClipper clipper;
+        clipper.Begin((int)g_comboItems.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const std::string& name = g_comboItems[i];
+                const bool is_selected = selected == name;
+                if (ImGui::Selectable(name.c_str(), is_selected)) {
+                    selected = name;
+                    picked = true;
+                }
+                if (is_selected) ImGui::SetItemDefaultFocus();
+            }
+        }
+        return picked;
     }
 
     void UpdateNodeSpriteReferences(Node* node, const std::string& oldName, const std::string& newName, SpriteData* spriteData) {
@@ -39,12 +64,7 @@ namespace {
         if (!canLink) ImGui::BeginDisabled();
 
         if (ImGui::BeginCombo("##LinkToState", activeStateData.linkToStateName.c_str())) {
-            for (auto const& [stateName, stateData] : selectedSprite.states) {
-                if (stateName != localActiveState) {
-                    if (ImGui::Selectable(stateName.c_str(), activeStateData.linkToStateName == stateName)) activeStateData.linkToStateName = stateName;
-                    if (activeStateData.linkToStateName == stateName) ImGui::SetItemDefaultFocus();
-                }
-            }
+            ClippedComboItems(selectedSprite.states, activeStateData.linkToStateName, localActiveState);
             ImGui::EndCombo();
         }
         if (!canLink) ImGui::EndDisabled();
@@ -53,44 +73,48 @@ namespace {
     void RenderFramesEditor(SpriteState& activeStateData, SpriteData* spriteData, const std::string& selectedSpriteName, std::string& successMessage, std::string& errorMessage) {
         ImGui::BeginChild("FrameList", ImVec2(0, 150), true);
         int frame_to_delete = -1;
-        for (int i = 0; i < activeStateData.frames.size(); ++i) {
-            ImGui::PushID(i);
-            SpriteFrame& frame = activeStateData.frames[i];
-            char pathBuffer[256];
-            strncpy_s(pathBuffer, frame.texturePath.c_str(), sizeof(pathBuffer));
-            ImGui::Text("Frame %d", i + 1);
-            ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - 30);
-            if (ImGui::InputText("##TexturePath", pathBuffer, sizeof(pathBuffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
-                std::string newPath = pathBuffer;
-                if (newPath != frame.texturePath) {
-                    GLuint newTextureId = TextureLoader::LoadOrGetTexture(newPath, *spriteData, errorMessage);
-                    if (newTextureId != 0) {
-                        frame.textureId = newTextureId;
-                        frame.texturePath = newPath;
-                        glBindTexture(GL_TEXTURE_2D, newTextureId);
-                        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &frame.width);
-                        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &frame.height);
-                        successMessage = "Texture updated successfully!";
-                    }
-                    else {
-                        successMessage.clear();
+        ImGuiListClipper clipper;
+        clipper.Begin((int)activeStateData.frames.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                ImGui::PushID(i);
+                SpriteFrame& frame = activeStateData.frames[i];
+                char pathBuffer[256];
+                strncpy_s(pathBuffer, frame.texturePath.c_str(), sizeof(pathBuffer));
+                ImGui::Text("Frame %d", i + 1);
+                ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x - 30);
+                if (ImGui::InputText("##TexturePath", pathBuffer, sizeof(pathBuffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
+                    std::string newPath = pathBuffer;
+                    if (newPath != frame.texturePath) {
+                        bool wasDrawable = frame.textureId != 0;
+                        if (TextureLoader::AssignTexture(frame, newPath, *spriteData, errorMessage)) {
+                            if (!wasDrawable) PivotLogic::MarkRigDirty(spriteData);
+                            else PivotLogic::MarkSpriteDirty(spriteData, &spriteData->sprites.at(selectedSpriteName));
+                            successMessage = "Texture updated successfully!";
+                        }
+                        else {
+                            successMessage.clear();
+                        }
                     }
                 }
+                ImGui::PopItemWidth();
+                ImGui::SameLine();
+                if (ImGui::Button("-")) {
+                    frame_to_delete = i;
+                }
+                ImGui::PopID();
             }
-            ImGui::PopItemWidth();
-            ImGui::SameLine();
-            if (ImGui::Button("-")) {
-                frame_to_delete = i;
-            }
-            ImGui::PopID();
         }
         if (frame_to_delete != -1) {
             activeStateData.frames.erase(activeStateData.frames.begin() + frame_to_delete);
+            TextureLoader::RefreshReferences(*spriteData);
+            PivotLogic::MarkRigDirty(spriteData);
         }
         ImGui::EndChild();
 
         if (ImGui::Button("Add Frame", ImVec2(-1, 0))) {
             activeStateData.frames.push_back(SpriteFrame{});
+            PivotLogic::MarkRigDirty(spriteData);
         }
 
         ImGui::Separator();
@@ -108,10 +132,7 @@ namespace {
             ImGui::PopStyleColor();
             ImGui::Separator();
 
-            for (auto const& [stateName, stateData] : spriteData->sprites.at(selectedSpriteName).states) {
-                if (ImGui::Selectable(stateName.c_str(), activeStateData.nextState == stateName)) activeStateData.nextState = stateName;
-                if (activeStateData.nextState == stateName) ImGui::SetItemDefaultFocus();
-            }
+            ClippedComboItems(spriteData->sprites.at(selectedSpriteName).states, activeStateData.nextState);
             ImGui::EndCombo();
         }
         if (!canSelectNext) ImGui::EndDisabled();
@@ -127,13 +148,13 @@ namespace SpriteEditor {
         ImGui::SameLine(ImGui::GetWindowContentRegionMax().x - 60);
         if (ImGui::Button("+##AddSprite")) {
             if (spriteData) {
-                std::set<std::string> existingNames;
-                for (const auto& pair : spriteData->sprites) existingNames.insert(pair.first);
-                std::string newName = GenerateUniqueName("New Sprite", existingNames);
+                std::string newName = spriteData->spriteNames.Unique("New Sprite");
                 Sprite newSprite;
                 newSprite.name = newName;
                 newSprite.states["Normal"] = SpriteState();
+                newSprite.stateNames.Add("Normal");
                 spriteData->sprites[newName] = newSprite;
+                spriteData->spriteNames.Add(newName);
                 selectedSpriteName = newName;
             }
         }
@@ -152,6 +173,9 @@ namespace SpriteEditor {
             if (ImGui::Button("Delete", ImVec2(120, 0))) {
                 UpdateNodeSpriteReferences(spriteData->root.get(), selectedSpriteName, "", spriteData);
                 spriteData->sprites.erase(selectedSpriteName);
+                spriteData->spriteNames.Remove(selectedSpriteName);
+                TextureLoader::RefreshReferences(*spriteData);
+                PivotLogic::MarkRigDirty(spriteData);
                 if (!spriteData->sprites.empty()) {
                     selectedSpriteName = spriteData->sprites.begin()->first;
                 }
@@ -175,14 +199,7 @@ namespace SpriteEditor {
         }
 
         if (ImGui::BeginCombo("Active", selectedSpriteName.c_str())) {
-            for (auto const& [name, sprite] : spriteData->sprites) {
-                bool is_selected = (selectedSpriteName == name);
-                if (ImGui::Selectable(name.c_str(), is_selected)) {
-                    selectedSpriteName = name;
-                    localActiveState = "Normal";
-                }
-                if (is_selected) ImGui::SetItemDefaultFocus();
-            }
+            if (ClippedComboItems(spriteData->sprites, selectedSpriteName)) localActiveState = "Normal";
             ImGui::EndCombo();
         }
 
@@ -199,12 +216,14 @@ namespace SpriteEditor {
         ImGui::Text("Sprite Name");
         if (ImGui::InputText("##SpriteName", nameBuffer, sizeof(nameBuffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
             std::string newName = nameBuffer;
-            if (newName != selectedSprite.name && !spriteData->sprites.count(newName)) {
+            if (newName != selectedSprite.name && !spriteData->spriteNames.Contains(newName)) {
                 auto nodeHandler = spriteData->sprites.extract(selectedSprite.name);
                 nodeHandler.key() = newName;
                 nodeHandler.mapped().name = newName;
                 spriteData->sprites.insert(std::move(nodeHandler));
+                spriteData->spriteNames.Rename(selectedSpriteName, newName);
                 UpdateNodeSpriteReferences(spriteData->root.get(), selectedSpriteName, newName, spriteData);
+                PivotLogic::MarkRigDirty(spriteData);
                 selectedSpriteName = newName;
             }
         }
@@ -212,17 +231,14 @@ namespace SpriteEditor {
         ImGui::Text("State");
         ImGui::SameLine();
         if (ImGui::Button("+##AddState")) {
-            std::set<std::string> existingNames;
-            for (const auto& pair : selectedSprite.states) existingNames.insert(pair.first);
-            localActiveState = GenerateUniqueName("State", existingNames);
+            localActiveState = selectedSprite.stateNames.Unique("State");
             selectedSprite.states[localActiveState] = SpriteState();
+            selectedSprite.stateNames.Add(localActiveState);
+            PivotLogic::MarkRigDirty(spriteData);
         }
 
         if (ImGui::BeginCombo("##StateCombo", localActiveState.c_str())) {
-            for (auto const& [stateName, stateData] : selectedSprite.states) {
-                if (ImGui::Selectable(stateName.c_str(), localActiveState == stateName)) localActiveState = stateName;
-                if (localActiveState == stateName) ImGui::SetItemDefaultFocus();
-            }
+            ClippedComboItems(selectedSprite.states, localActiveState);
             ImGui::EndCombo();
         }
 
@@ -240,14 +256,16 @@ namespace SpriteEditor {
         ImGui::Text("State Name");
         if (localActiveState != "Normal" && ImGui::InputText("##StateName", stateNameBuffer, sizeof(stateNameBuffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
             std::string newName = stateNameBuffer;
-            if (newName != localActiveState && !selectedSprite.states.count(newName)) {
+            if (newName != localActiveState && !selectedSprite.stateNames.Contains(newName)) {
                 auto nodeHandler = selectedSprite.states.extract(localActiveState);
                 nodeHandler.key() = newName;
                 selectedSprite.states.insert(std::move(nodeHandler));
+                selectedSprite.stateNames.Rename(localActiveState, newName);
                 for (auto& pair : selectedSprite.states) {
                     if (pair.second.isLink && pair.second.linkToStateName == localActiveState) pair.second.linkToStateName = newName;
                     if (pair.second.nextState == localActiveState) pair.second.nextState = newName;
                 }
+                PivotLogic::MarkRigDirty(spriteData);
                 localActiveState = newName;
             }
         }
@@ -256,7 +274,10 @@ namespace SpriteEditor {
         SpriteState& activeStateData = selectedSprite.states.at(localActiveState);
         const char* types[] = { "Frames", "Link" };
         int typeIndex = activeStateData.isLink ? 1 : 0;
-        if (ImGui::Combo("Type", &typeIndex, types, IM_ARRAYSIZE(types))) activeStateData.isLink = (typeIndex == 1);
+        if (ImGui::Combo("Type", &typeIndex, types, IM_ARRAYSIZE(types))) {
+            activeStateData.isLink = (typeIndex == 1);
+            PivotLogic::MarkRigDirty(spriteData);
+        }
 
         ImGui::Separator();
 
@@ -281,6 +302,9 @@ namespace SpriteEditor {
             ImGui::Separator();
             if (ImGui::Button("Delete", ImVec2(120, 0))) {
                 selectedSprite.states.erase(localActiveState);
+                selectedSprite.stateNames.Remove(localActiveState);
+                TextureLoader::RefreshReferences(*spriteData);
+                PivotLogic::MarkRigDirty(spriteData);
                 localActiveState = "Normal";
                 ImGui::CloseCurrentPopup();
             }
@@ -0,0 +1,145 @@
+#include "texture_cache.h"
+#include "texture_upload.h"
+#include "environment.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+    constexpr size_t ATLAS_PAGE_BYTES = (size_t)2048 * 2048 * 4;
+
+    struct CachedTexture {
+        TextureEntry entry;
+        size_t bytes = 0;
+        int refs = 0;
+        unsigned long long lastUse = 0;
+    };
+
+    struct CachedPage {
+        GLuint textureId = 0;
+        unsigned long long lastUse = 0;
+    };
+
+    std::map<std::string, CachedTexture> g_textures;
+    std::map<int, CachedPage> g_pages;
+    int g_nextPage = 0;
+    unsigned long long g_clock = 0;
+    size_t g_residentBytes = 0;
+
+    void delete_texture(GLuint textureId) {
+        if (textureId == 0) return;
+        TextureUpload::Cancel(textureId);
+        glDeleteTextures(1, &textureId);
+    }
+
+    void touch(CachedTexture& texture) {
+        texture.lastUse = ++g_clock;
+        if (texture.entry.atlasPage >= 0) {
+            auto page = g_pages.find(texture.entry.atlasPage);
+            if (page != g_pages.end()) page->second.lastUse = texture.lastUse;
+        }
+    }
+}
+
+const TextureEntry* TextureCache::Find(const std::string& sourcePath) {
+    auto it = g_textures.find(sourcePath);
+    return it == g_textures.end() ? nullptr : &it->second.entry;
+}
+
+void TextureCache::Insert(const TextureEntry& entry, size_t bytes) {
+    CachedTexture& texture = g_textures[entry.sourcePath];
+    if (texture.entry.atlasPage < 0 && texture.entry.textureId != entry.textureId) delete_texture(texture.entry.textureId);
+    g_residentBytes -= texture.bytes;
+
+    texture.entry = entry;
+    texture.bytes = entry.atlasPage >= 0 ? 0 : bytes;
+    g_residentBytes += texture.bytes;
+    touch(texture);
+}
+
+int TextureCache::AddAtlasPage(GLuint textureId) {
+    int page = g_nextPage++;
+    g_pages[page] = { textureId, ++g_clock };
+    g_residentBytes += ATLAS_PAGE_BYTES;
+    return page;
+}
+
+GLuint TextureCache::AtlasPageTexture(int page) {
+    auto it = g_pages.find(page);
+    return it == g_pages.end() ? 0 : it->second.textureId;
+}
+
+void TextureCache::Acquire(const std::string& sourcePath, int count) {
+    auto it = g_textures.find(sourcePath);
+    if (it == g_textures.end()) return;
+    it->second.refs += count;
+    touch(it->second);
+}
+
+void TextureCache::Release(const std::string& sourcePath, int count) {
+    auto it = g_textures.find(sourcePath);
+    if (it == g_textures.end()) return;
+    it->second.refs = std::max(0, it->second.refs - count);
+    touch(it->second);
+}
+
+void TextureCache::Trim() {
+    const size_t budget = BudgetBytes();
+    if (g_residentBytes <= budget) return;
+
+    // Eviction candidates: unreferenced standalone textures, and pages whose
+    // entries are all unreferenced; the oldest of either kind goes first.
+    std::map<int, bool> page_in_use;
+    for (const auto& [path, texture] : g_textures) {
+        if (texture.entry.atlasPage >= 0 && texture.refs > 0) page_in_use[texture.entry.atlasPage] = true;
+    }
+    std::vector<std::pair<unsigned long long, std::string>> standalone;
+    std::vector<std::pair<unsigned long long, int>> pages;
+    for (const auto& [path, texture] : g_textures) {
+        if (texture.entry.atlasPage < 0 && texture.refs == 0) standalone.push_back({ texture.lastUse, path });
+    }
+    for (const auto& [page, cached] : g_pages) {
+        if (!page_in_use.count(page)) pages.push_back({ cached.lastUse, page });
+    }
+    std::sort(standalone.begin(), standalone.end());
+    std::sort(pages.begin(), pages.end());
+
+    size_t s = 0, p = 0;
+    while (g_residentBytes > budget && (s < standalone.size() || p < pages.size())) {
+        bool take_page = s >= standalone.size() || (p < pages.size() && pages[p].first < standalone[s].first);
+        if (take_page) {
+            int page = pages[p++].second;
+            for (auto it = g_textures.begin(); it != g_textures.end();) {
+                if (it->second.entry.atlasPage == page) it = g_textures.erase(it);
+                else ++it;
+            }
+            delete_texture(g_pages[page].textureId);
+            g_pages.erase(page);
+            g_residentBytes -= ATLAS_PAGE_BYTES;
+        }
+        else {
+            auto it = g_textures.find(standalone[s++].second);
+            delete_texture(it->second.entry.textureId);
+            g_residentBytes -= it->second.bytes;
+            g_textures.erase(it);
+        }
+    }
+}
+
+size_t TextureCache::ResidentBytes() {
+    return g_residentBytes;
+}
+
+size_t TextureCache::BudgetBytes() {
+    return (size_t)(Environment::GetTextureBudgetMB() * 1024.0 * 1024.0);
+}
+
+void TextureCache::Clear() {
+    for (const auto& [path, texture] : g_textures) {
+        if (texture.entry.atlasPage < 0) delete_texture(texture.entry.textureId);
+    }
+    for (const auto& [page, cached] : g_pages) delete_texture(cached.textureId);
+    g_textures.clear();
+    g_pages.clear();
+    g_residentBytes = 0;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include "datatypes.h"
+#include <GL/glew.h>
+#include <string>
+
+struct TextureEntry {
+    std::string sourcePath;
+    GLuint textureId = 0;
+    int width = 0;
+    int height = 0;
+    int atlasPage = -1;
+    Vec2 uvMin = { 0.0f, 0.0f };
+    Vec2 uvMax = { 1.0f, 1.0f };
+    std::shared_ptr<const AlphaMask::Mask> alphaMask;
+};
+
+namespace TextureCache {
+    // Resident textures keyed by resolved file path. They outlive any single
+    // SpriteData: entries nobody references stay resident until the VRAM budget
+    // is exceeded, then the least recently used ones are evicted. Atlas pages
+    // are evicted as a whole once none of their entries is referenced.
+    const TextureEntry* Find(const std::string& sourcePath);
+    // Adds or replaces an entry; a replaced standalone texture is deleted.
+    void Insert(const TextureEntry& entry, size_t bytes);
+    // Registers an atlas page texture and returns its page id.
+    int AddAtlasPage(GLuint textureId);
+    GLuint AtlasPageTexture(int page);
+
+    void Acquire(const std::string& sourcePath, int count);
+    void Release(const std::string& sourcePath, int count);
+    void Trim();
+
+    size_t ResidentBytes();
+    size_t BudgetBytes();
+    void Clear();
+}
\ No newline at end of file
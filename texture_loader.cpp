@@ -1,140 +1,465 @@
 #include "texture_loader.h"
-#include "environment.h"
+#include "vfs.h"
+#include "thread_pool.h"
+#include "texture_upload.h"
+#include "image_decoder.h"
+#include "texture_cache.h"
+#include "alpha_mask.h"
+#include "trace.h"
 #include <filesystem>
-#include <fstream>
-#include <iostream>
-#include <il/il.h>
-#include <IL/ilu.h>
 #include <gli/gli.hpp>
 #include <algorithm>
 #include <vector>
+#include <set>
+#include <cstring>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
 namespace {
-    std::filesystem::path find_absolute_path(const std::string& relative_path) {
-        std::filesystem::path file_path(relative_path);
-        if (file_path.empty()) return "";
-        if (file_path.is_absolute() && std::filesystem::exists(file_path)) return file_path.lexically_normal();
+    constexpr int ATLAS_PAGE_SIZE = 2048;
+    constexpr int ATLAS_PADDING = 1;
 
-        for (const auto& base_str : Environment::GetSearchPaths()) {
-            std::filesystem::path full_path = std::filesystem::path(base_str) / file_path;
-            if (std::filesystem::exists(full_path = full_path.lexically_normal())) return full_path;
+    std::filesystem::path resolve_texture_path(const std::string& texture_relative_path) {
+        return Vfs::Resolve(texture_relative_path, SUPPORTED_IMAGE_EXTENSIONS);
+    }
+
+    bool is_dds(const std::filesystem::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".dds";
+    }
+
+    // DevIL trolling, no dds for devil then
+    bool ReadDDS(const std::filesystem::path& found_path, gli::texture& texture, std::string& errorMessage) {
+        texture = gli::load(found_path.string());
+        if (texture.empty()) {
+            errorMessage = "GLI Error: Failed to load DDS file " + found_path.string();
+            return false;
         }
-        return "";
+        return true;
     }
 
-    GLuint LoadTextureFromFile(const std::string& texture_relative_path, std::string& errorMessage) {
-        std::filesystem::path found_path;
-        std::filesystem::path original_path(texture_relative_path);
+    void UploadDDS(const gli::texture& texture, TextureEntry& entry) {
+        Trace::Scope trace("upload DDS", "texture");
+        trace.Arg("path", entry.sourcePath);
+        trace.Arg("bytes", (double)texture.size());
+        trace.Arg("levels", (double)texture.levels());
+        gli::gl GL(gli::gl::PROFILE_GL33);
+        gli::gl::format const format = GL.translate(texture.format(), texture.swizzles());
+        GLenum target = GL.translate(texture.target());
 
-        found_path = find_absolute_path(texture_relative_path);
+        GLuint textureID = 0;
+        glGenTextures(1, &textureID);
+        glBindTexture(target, textureID);
 
-        if (found_path.empty()) {
-            std::filesystem::path path_without_ext = original_path;
-            path_without_ext.replace_extension();
+        glm::tvec3<GLsizei> const extent(texture.extent());
 
-            for (const auto& ext : SUPPORTED_IMAGE_EXTENSIONS) {
-                std::filesystem::path new_path = path_without_ext;
-                new_path += ext;
-                found_path = find_absolute_path(new_path.string());
-                if (!found_path.empty()) {
-                    break;
-                }
+        glTexStorage2D(target, static_cast<GLint>(texture.levels()), format.Internal, extent.x, extent.y);
+        for (std::size_t level = 0; level < texture.levels(); ++level)
+        {
+            glm::tvec3<GLsizei> level_extent(texture.extent(level));
+            if (gli::is_compressed(texture.format())) {
+                glCompressedTexSubImage2D(target, static_cast<GLint>(level), 0, 0, level_extent.x, level_extent.y, format.Internal, static_cast<GLsizei>(texture.size(level)), texture.data(0, 0, level));
+            }
+            else {
+                glTexSubImage2D(target, static_cast<GLint>(level), 0, 0, level_extent.x, level_extent.y, format.External, format.Type, texture.data(0, 0, level));
             }
         }
+        entry.textureId = textureID;
+        entry.width = extent.x;
+        entry.height = extent.y;
+    }
+
+    std::shared_ptr<const AlphaMask::Mask> build_mask(const DecodedImage& image) {
+        auto mask = std::make_shared<AlphaMask::Mask>();
+        AlphaMask::Build(image.pixels.data(), image.width, image.height, *mask);
+        return mask;
+    }
 
-        if (found_path.empty()) {
-            errorMessage = "Image not found: " + texture_relative_path;
-            return 0;
+    bool LoadStandalone(const std::filesystem::path& found_path, TextureEntry& entry, size_t& bytes, std::string& errorMessage) {
+        entry.sourcePath = found_path.string();
+        if (is_dds(found_path)) {
+            gli::texture texture;
+            if (!ReadDDS(found_path, texture, errorMessage)) return false;
+            UploadDDS(texture, entry);
+            bytes = texture.size();
+            return true;
         }
-        
-        std::string ext = found_path.extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
-        // DevIL trolling, no dds for devil then
-        if (ext == ".dds") {
-            gli::texture texture = gli::load(found_path.string());
-            if (texture.empty()) {
-                errorMessage = "GLI Error: Failed to load DDS file " + found_path.string();
-                return 0;
+        DecodedImage image;
+        if (!ImageDecoder::Decode(found_path, image, errorMessage)) return false;
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.alphaMask = build_mask(image);
+        bytes = image.pixels.size();
+        entry.textureId = TextureUpload::CreateStreamed(image.width, image.height, std::move(image.pixels));
+        return true;
+    }
+
+    // Copies the image with its border pixels extruded into the padding so
+    // bilinear filtering at the edges never samples a neighbouring sprite.
+    // dst points at the image's top-left pixel inside a larger buffer.
+    void BlitExtruded(const DecodedImage& image, unsigned char* dst_origin, size_t stride) {
+        for (int row = -ATLAS_PADDING; row < image.height + ATLAS_PADDING; ++row) {
+            int src_row = std::clamp(row, 0, image.height - 1);
+            const unsigned char* src = image.pixels.data() + (size_t)src_row * image.width * 4;
+            unsigned char* dst = dst_origin + (ptrdiff_t)row * (ptrdiff_t)stride;
+            for (int p = 1; p <= ATLAS_PADDING; ++p) {
+                std::memcpy(dst - p * 4, src, 4);
+                std::memcpy(dst + ((size_t)image.width + p - 1) * 4, src + ((size_t)image.width - 1) * 4, 4);
             }
+            std::memcpy(dst, src, (size_t)image.width * 4);
+        }
+    }
 
-            gli::gl GL(gli::gl::PROFILE_GL33);
-            gli::gl::format const format = GL.translate(texture.format(), texture.swizzles());
-            GLenum target = GL.translate(texture.target());
+    // Skyline bottom-left packer: the skyline is a list of horizontal segments
+    // covering the page width, and each rectangle goes where its top edge ends
+    // up lowest.
+    struct AtlasPage {
+        struct Segment { int x, y, width; };
+        std::vector<Segment> skyline{ { 0, 0, ATLAS_PAGE_SIZE } };
+        std::vector<unsigned char> pixels = std::vector<unsigned char>((size_t)ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4, 0);
 
-            GLuint textureID = 0;
-            glGenTextures(1, &textureID);
-            glBindTexture(target, textureID);
+        int FitAt(size_t index, int width, int height) const {
+            if (skyline[index].x + width > ATLAS_PAGE_SIZE) return -1;
+            int y = 0;
+            int remaining = width;
+            for (size_t i = index; remaining > 0; ++i) {
+                if (i >= skyline.size()) return -1;
+                y = std::max(y, skyline[i].y);
+                if (y + height > ATLAS_PAGE_SIZE) return -1;
+                remaining -= skyline[i].width;
+            }
+            return y;
+        }
 
-            glm::tvec3<GLsizei> const extent(texture.extent());
+        bool Insert(int width, int height, int& out_x, int& out_y) {
+            int best_index = -1, best_y = ATLAS_PAGE_SIZE, best_width = ATLAS_PAGE_SIZE + 1;
+            for (size_t i = 0; i < skyline.size(); ++i) {
+                int y = FitAt(i, width, height);
+                if (y < 0) continue;
+                if (y + height < best_y + height || (y == best_y && skyline[i].width < best_width)) {
+                    best_index = (int)i; best_y = y; best_width = skyline[i].width;
+                }
+            }
+            if (best_index < 0) return false;
 
-            glTexStorage2D(target, static_cast<GLint>(texture.levels()), format.Internal, extent.x, extent.y);
-            for (std::size_t level = 0; level < texture.levels(); ++level)
-            {
-                glm::tvec3<GLsizei> level_extent(texture.extent(level));
-                if (gli::is_compressed(texture.format())) {
-                    glCompressedTexSubImage2D(target, static_cast<GLint>(level), 0, 0, level_extent.x, level_extent.y, format.Internal, static_cast<GLsizei>(texture.size(level)), texture.data(0, 0, level));
+            out_x = skyline[best_index].x;
+            out_y = best_y;
+            skyline.insert(skyline.begin() + best_index, { out_x, out_y + height, width });
+            for (size_t i = best_index + 1; i < skyline.size();) {
+                int shrink = (skyline[i - 1].x + skyline[i - 1].width) - skyline[i].x;
+                if (shrink <= 0) break;
+                skyline[i].x += shrink;
+                skyline[i].width -= shrink;
+                if (skyline[i].width > 0) break;
+                skyline.erase(skyline.begin() + i);
+            }
+            for (size_t i = 0; i + 1 < skyline.size();) {
+                if (skyline[i].y == skyline[i + 1].y) {
+                    skyline[i].width += skyline[i + 1].width;
+                    skyline.erase(skyline.begin() + i + 1);
                 }
                 else {
-                    glTexSubImage2D(target, static_cast<GLint>(level), 0, 0, level_extent.x, level_extent.y, format.External, format.Type, texture.data(0, 0, level));
+                    ++i;
                 }
             }
-            return textureID;
+            return true;
         }
 
-        // For all other formats, use DevIL
-        std::ifstream file(found_path, std::ios::binary | std::ios::ate);
-        if (!file.is_open()) {
-            errorMessage = "Error: Could not open file " + found_path.string();
-            return 0;
+        void Blit(const DecodedImage& image, int x, int y) {
+            const size_t stride = (size_t)ATLAS_PAGE_SIZE * 4;
+            BlitExtruded(image, pixels.data() + (size_t)y * stride + (size_t)x * 4, stride);
         }
-        std::vector<char> buffer(file.tellg());
-        file.seekg(0, std::ios::beg);
-        if (!file.read(buffer.data(), buffer.size())) {
-            errorMessage = "Error: Could not read file " + found_path.string();
-            return 0;
+    };
+
+    // The image plus its padding ring, ready to replace an atlas slot in place.
+    std::vector<unsigned char> Extrude(const DecodedImage& image) {
+        const int padded_width = image.width + ATLAS_PADDING * 2;
+        const size_t stride = (size_t)padded_width * 4;
+        std::vector<unsigned char> padded(stride * (image.height + ATLAS_PADDING * 2));
+        BlitExtruded(image, padded.data() + ATLAS_PADDING * stride + ATLAS_PADDING * 4, stride);
+        return padded;
+    }
+
+    void ApplyEntry(SpriteFrame& frame, const TextureEntry& entry) {
+        frame.textureId = (TextureHandle)entry.textureId;
+        frame.width = entry.width;
+        frame.height = entry.height;
+        frame.uvMin = entry.uvMin;
+        frame.uvMax = entry.uvMax;
+        frame.alphaMask = entry.alphaMask;
+    }
+
+    struct DecodeJob {
+        std::filesystem::path foundPath;
+        gli::texture dds;
+        DecodedImage image;
+        std::shared_ptr<const AlphaMask::Mask> mask;
+        std::string error;
+    };
+
+    void decode_job(DecodeJob& job) {
+        Trace::Scope trace("decode", "texture");
+        trace.Arg("path", job.foundPath.string());
+        trace.Arg("format", job.foundPath.extension().string());
+        if (is_dds(job.foundPath)) {
+            ReadDDS(job.foundPath, job.dds, job.error);
+            trace.Arg("bytes", (double)job.dds.size());
+        }
+        else {
+            if (ImageDecoder::Decode(job.foundPath, job.image, job.error)) job.mask = build_mask(job.image);
+            trace.Arg("bytes", (double)job.image.pixels.size());
         }
+    }
 
-        ILuint imageID;
-        ilGenImages(1, &imageID); ilBindImage(imageID);
-        if (!ilLoadL(IL_TYPE_UNKNOWN, buffer.data(), buffer.size())) {
-            ILenum err = ilGetError();
-            errorMessage = "DevIL Load Error " + std::to_string(err);
-            ilDeleteImages(1, &imageID); return 0;
+    template <typename Fn>
+    void ForEachFrame(SpriteData& spriteData, Fn fn) {
+        for (auto& sprite_pair : spriteData.sprites) {
+            for (auto& state_pair : sprite_pair.second.states) {
+                for (auto& frame : state_pair.second.frames) fn(frame);
+            }
         }
-        if (ilGetInteger(IL_IMAGE_ORIGIN) == IL_ORIGIN_LOWER_LEFT) iluFlipImage();
-        if (!ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE)) {
-            ILenum err = ilGetError();
-            errorMessage = "DevIL Convert Error " + std::to_string(err);
-            ilDeleteImages(1, &imageID); return 0;
+    }
+}
+
+void TextureLoader::LoadSpriteTextures(SpriteData& spriteData, std::string& errorMessage) {
+    Trace::Scope trace("LoadSpriteTextures", "texture");
+    std::vector<std::string> paths;
+    std::set<std::string> seen;
+    ForEachFrame(spriteData, [&](SpriteFrame& frame) {
+        if (frame.texturePath.empty() || spriteData.texturePaths.count(frame.texturePath)) return;
+        if (seen.insert(frame.texturePath).second) paths.push_back(frame.texturePath);
+    });
+
+    std::vector<std::filesystem::path> found(paths.size());
+    {
+        Trace::Scope resolve_trace("resolve textures", "texture");
+        resolve_trace.Arg("count", (double)paths.size());
+        ThreadPool::ParallelFor(paths.size(), [&](size_t i) { found[i] = resolve_texture_path(paths[i]); });
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (found[i].empty()) {
+            errorMessage = "Image not found: " + paths[i];
+            RefreshReferences(spriteData);
+            return;
         }
+    }
 
-        GLuint textureId;
-        glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ilGetInteger(IL_IMAGE_WIDTH), ilGetInteger(IL_IMAGE_HEIGHT), 0, GL_RGBA, GL_UNSIGNED_BYTE, ilGetData());
-        ilDeleteImages(1, &imageID);
-        return textureId;
+    // Only files that are not resident yet are decoded; decoding and file
+    // reads run on the pool, GL uploads stay on this thread.
+    std::vector<DecodeJob> jobs;
+    std::set<std::string> queued;
+    for (const auto& path : found) {
+        if (TextureCache::Find(path.string()) || !queued.insert(path.string()).second) continue;
+        jobs.emplace_back();
+        jobs.back().foundPath = path;
     }
+    ThreadPool::ParallelFor(jobs.size(), [&](size_t i) { decode_job(jobs[i]); });
+
+    for (const DecodeJob& job : jobs) {
+        if (!job.error.empty()) {
+            errorMessage = job.error;
+            RefreshReferences(spriteData);
+            return;
+        }
+    }
+
+    std::vector<size_t> packable;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (is_dds(jobs[i].foundPath)) {
+            TextureEntry entry;
+            entry.sourcePath = jobs[i].foundPath.string();
+            UploadDDS(jobs[i].dds, entry);
+            TextureCache::Insert(entry, jobs[i].dds.size());
+            jobs[i].dds = gli::texture();
+            continue;
+        }
+        packable.push_back(i);
+    }
+
+    std::sort(packable.begin(), packable.end(), [&](size_t a, size_t b) {
+        const DecodedImage& image_a = jobs[a].image;
+        const DecodedImage& image_b = jobs[b].image;
+        if (image_a.height != image_b.height) return image_a.height > image_b.height;
+        return image_a.width > image_b.width;
+    });
+
+    Trace::Scope pack_trace("pack atlas", "texture");
+    pack_trace.Arg("textures", (double)packable.size());
+    std::vector<AtlasPage> pages;
+    std::vector<std::pair<TextureEntry, int>> packed;
+    for (size_t i : packable) {
+        DecodedImage& image = jobs[i].image;
+        TextureEntry entry;
+        entry.sourcePath = jobs[i].foundPath.string();
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.alphaMask = jobs[i].mask;
+
+        int padded_width = image.width + ATLAS_PADDING * 2;
+        int padded_height = image.height + ATLAS_PADDING * 2;
+        int x = 0, y = 0;
+        int page_index = -1;
+        if (image.width > 0 && image.height > 0 && padded_width <= ATLAS_PAGE_SIZE && padded_height <= ATLAS_PAGE_SIZE) {
+            for (size_t p = 0; p < pages.size() && page_index < 0; ++p) {
+                if (pages[p].Insert(padded_width, padded_height, x, y)) page_index = (int)p;
+            }
+            if (page_index < 0) {
+                pages.emplace_back();
+                if (pages.back().Insert(padded_width, padded_height, x, y)) page_index = (int)pages.size() - 1;
+            }
+        }
+
+        if (page_index < 0) {
+            size_t bytes = image.pixels.size();
+            entry.textureId = TextureUpload::CreateStreamed(image.width, image.height, std::move(image.pixels));
+            TextureCache::Insert(entry, bytes);
+        }
+        else {
+            pages[page_index].Blit(image, x + ATLAS_PADDING, y + ATLAS_PADDING);
+            std::vector<unsigned char>().swap(image.pixels);
+            entry.uvMin = { (float)(x + ATLAS_PADDING) / ATLAS_PAGE_SIZE, (float)(y + ATLAS_PADDING) / ATLAS_PAGE_SIZE };
+            entry.uvMax = { (float)(x + ATLAS_PADDING + image.width) / ATLAS_PAGE_SIZE, (float)(y + ATLAS_PADDING + image.height) / ATLAS_PAGE_SIZE };
+            packed.push_back({ entry, page_index });
+        }
+    }
+
+    pack_trace.Arg("pages", (double)pages.size());
+    std::vector<int> page_ids;
+    for (AtlasPage& page : pages) {
+        page_ids.push_back(TextureCache::AddAtlasPage(TextureUpload::CreateStreamed(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, std::move(page.pixels))));
+    }
+    for (auto& [entry, page_index] : packed) {
+        entry.atlasPage = page_ids[page_index];
+        entry.textureId = TextureCache::AtlasPageTexture(entry.atlasPage);
+        TextureCache::Insert(entry, 0);
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) spriteData.texturePaths[paths[i]] = found[i].string();
+    RefreshReferences(spriteData);
 }
 
-GLuint TextureLoader::LoadOrGetTexture(const std::string& path, SpriteData& spriteData, std::string& errorMessage) {
+bool TextureLoader::AssignTexture(SpriteFrame& frame, const std::string& path, SpriteData& spriteData, std::string& errorMessage) {
+    Trace::Scope trace("AssignTexture", "texture");
+    trace.Arg("path", path);
     if (path.empty()) {
-        return 0;
+        return false;
+    }
+    std::filesystem::path found_path;
+    auto known = spriteData.texturePaths.find(path);
+    if (known != spriteData.texturePaths.end()) found_path = known->second;
+    else found_path = resolve_texture_path(path);
+    if (found_path.empty()) {
+        errorMessage = "Image not found: " + path;
+        return false;
+    }
+
+    if (!TextureCache::Find(found_path.string())) {
+        TextureEntry entry;
+        size_t bytes = 0;
+        if (!LoadStandalone(found_path, entry, bytes, errorMessage)) return false;
+        TextureCache::Insert(entry, bytes);
     }
-    if (spriteData.loadedTextures.count(path)) {
-        return spriteData.loadedTextures.at(path);
+    spriteData.texturePaths[path] = found_path.string();
+    frame.texturePath = path;
+    RefreshReferences(spriteData);
+    return true;
+}
+
+void TextureLoader::ReloadTextures(SpriteData& spriteData, const std::set<std::string>& changedFiles, std::string& errorMessage) {
+    std::vector<DecodeJob> jobs;
+    for (const auto& file : changedFiles) {
+        if (!TextureCache::Find(file)) continue;
+        jobs.emplace_back();
+        jobs.back().foundPath = file;
     }
+    if (jobs.empty()) return;
+
+    Trace::Scope trace("ReloadTextures", "texture");
+    trace.Arg("count", (double)jobs.size());
+    ThreadPool::ParallelFor(jobs.size(), [&](size_t i) { decode_job(jobs[i]); });
+
+    // A texture that fails to decode (e.g. caught mid-write) keeps its old pixels.
+    for (DecodeJob& job : jobs) {
+        if (!job.error.empty()) {
+            errorMessage = job.error;
+            continue;
+        }
+        TextureEntry entry = *TextureCache::Find(job.foundPath.string());
+        DecodedImage& image = job.image;
+        const bool same_size = !is_dds(job.foundPath) && image.width == entry.width && image.height == entry.height;
 
-    GLuint newTextureId = LoadTextureFromFile(path, errorMessage);
-    if (newTextureId != 0) {
-        spriteData.loadedTextures[path] = newTextureId;
+        if (same_size && entry.atlasPage >= 0) {
+            int x = (int)(entry.uvMin.x * ATLAS_PAGE_SIZE + 0.5f) - ATLAS_PADDING;
+            int y = (int)(entry.uvMin.y * ATLAS_PAGE_SIZE + 0.5f) - ATLAS_PADDING;
+            TextureUpload::UpdateRegion(entry.textureId, x, y, image.width + ATLAS_PADDING * 2, image.height + ATLAS_PADDING * 2, Extrude(image));
+            entry.alphaMask = job.mask;
+            TextureCache::Insert(entry, 0);
+        }
+        else if (same_size) {
+            size_t bytes = image.pixels.size();
+            TextureUpload::UpdateRegion(entry.textureId, 0, 0, image.width, image.height, std::move(image.pixels));
+            entry.alphaMask = job.mask;
+            TextureCache::Insert(entry, bytes);
+        }
+        else {
+            // The size changed, so it no longer fits its old slot; it moves to
+            // its own texture and any atlas slot is simply abandoned.
+            TextureEntry replacement;
+            replacement.sourcePath = entry.sourcePath;
+            size_t bytes = 0;
+            if (is_dds(job.foundPath)) {
+                UploadDDS(job.dds, replacement);
+                bytes = job.dds.size();
+            }
+            else {
+                replacement.width = image.width;
+                replacement.height = image.height;
+                replacement.alphaMask = job.mask;
+                bytes = image.pixels.size();
+                replacement.textureId = TextureUpload::CreateStreamed(image.width, image.height, std::move(image.pixels));
+            }
+            TextureCache::Insert(replacement, bytes);
+        }
     }
-    return newTextureId;
+    RefreshReferences(spriteData);
+}
+
+void TextureLoader::RefreshReferences(SpriteData& spriteData) {
+    std::map<std::string, int> refs;
+    ForEachFrame(spriteData, [&](SpriteFrame& frame) {
+        auto path = spriteData.texturePaths.find(frame.texturePath);
+        if (path == spriteData.texturePaths.end()) return;
+        const TextureEntry* entry = TextureCache::Find(path->second);
+        if (!entry) return;
+        ApplyEntry(frame, *entry);
+        ++refs[path->second];
+    });
+
+    for (const auto& [source, count] : refs) {
+        auto old = spriteData.textureRefs.find(source);
+        int delta = count - (old == spriteData.textureRefs.end() ? 0 : old->second);
+        if (delta > 0) TextureCache::Acquire(source, delta);
+        else if (delta < 0) TextureCache::Release(source, -delta);
+    }
+    for (const auto& [source, count] : spriteData.textureRefs) {
+        if (!refs.count(source)) TextureCache::Release(source, count);
+    }
+    spriteData.textureRefs = std::move(refs);
+
+    for (auto it = spriteData.texturePaths.begin(); it != spriteData.texturePaths.end();) {
+        if (spriteData.textureRefs.count(it->second)) ++it;
+        else it = spriteData.texturePaths.erase(it);
+    }
+    TextureCache::Trim();
+}
+
+void TextureLoader::ReleaseTextures(SpriteData& spriteData) {
+    for (const auto& [source, count] : spriteData.textureRefs) TextureCache::Release(source, count);
+    spriteData.textureRefs.clear();
+    spriteData.texturePaths.clear();
+    TextureCache::Trim();
 }
\ No newline at end of file
@@ -1,7 +1,23 @@
 #pragma once
 #include "datatypes.h"
+#include <set>
 #include <string>
 
 namespace TextureLoader {
-    GLuint LoadOrGetTexture(const std::string& path, SpriteData& spriteData, std::string& errorMessage);
+    // Loads every texture referenced by the sprites' frames that is not already
+    // resident in the TextureCache. New RGBA images are packed into shared atlas
+    // pages, DDS and oversized images get their own texture; frames receive
+    // their texture, size and UV rectangle. RGBA pixels stream in over the
+    // following frames through TextureUpload. Reference counts are refreshed
+    // on every exit, including errors.
+    void LoadSpriteTextures(SpriteData& spriteData, std::string& errorMessage);
+    bool AssignTexture(SpriteFrame& frame, const std::string& path, SpriteData& spriteData, std::string& errorMessage);
+    // Re-decodes every resident texture whose resolved file is in changedFiles
+    // and swaps the pixels in place; same-sized atlas slots are rewritten.
+    void ReloadTextures(SpriteData& spriteData, const std::set<std::string>& changedFiles, std::string& errorMessage);
+    // Recounts which textures the frames use and updates the cache's reference
+    // counts. Call after frames, states or sprites are removed or changed.
+    void RefreshReferences(SpriteData& spriteData);
+    // Drops every reference spriteData holds. The textures stay cached.
+    void ReleaseTextures(SpriteData& spriteData);
 }
\ No newline at end of file
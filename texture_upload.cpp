@@ -0,0 +1,204 @@
+#include "texture_upload.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <unordered_set>
+
+namespace {
+    constexpr GLsizeiptr STAGING_SLOT_SIZE = 4 * 1024 * 1024;
+    constexpr int STAGING_SLOTS = 3;
+
+    struct PendingUpload {
+        GLuint textureId = 0;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        int nextRow = 0;
+        bool placeholder = false;
+        std::vector<unsigned char> pixels;
+    };
+
+    // With ARB_buffer_storage the staging buffer is mapped once and split into
+    // slots guarded by fences; otherwise each chunk orphans a single PBO.
+    struct StagingBuffer {
+        GLuint buffer = 0;
+        bool persistent = false;
+        unsigned char* mapped = nullptr;
+        GLsync fences[STAGING_SLOTS] = {};
+        int slot = 0;
+    };
+
+    std::deque<PendingUpload> g_queue;
+    // Textures whose placeholder upload is still queued; the canvas asks per quad.
+    std::unordered_set<GLuint> g_placeholders;
+    StagingBuffer g_staging;
+
+    void init_staging() {
+        if (g_staging.buffer != 0) return;
+        glGenBuffers(1, &g_staging.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging.buffer);
+        if (GLEW_ARB_buffer_storage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, STAGING_SLOT_SIZE * STAGING_SLOTS, nullptr, flags);
+            g_staging.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, STAGING_SLOT_SIZE * STAGING_SLOTS, flags));
+            g_staging.persistent = g_staging.mapped != nullptr;
+            if (!g_staging.persistent) {
+                // Storage is immutable now, start over with a plain buffer.
+                glDeleteBuffers(1, &g_staging.buffer);
+                glGenBuffers(1, &g_staging.buffer);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging.buffer);
+            }
+        }
+        if (!g_staging.persistent) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, STAGING_SLOT_SIZE, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    // Returns false if the next persistent slot is still in flight. Rows are
+    // at most GL_MAX_TEXTURE_SIZE * 4 bytes, so one always fits in a slot.
+    bool upload_chunk(PendingUpload& upload) {
+        const size_t row_bytes = (size_t)upload.width * 4;
+        int rows = std::max(1, (int)(STAGING_SLOT_SIZE / (GLsizeiptr)row_bytes));
+        rows = std::min(rows, upload.height - upload.nextRow);
+        const size_t bytes = row_bytes * rows;
+        const unsigned char* src = upload.pixels.data() + row_bytes * upload.nextRow;
+        Trace::Scope trace("upload chunk", "texture");
+        trace.Arg("texture", (double)upload.textureId);
+        trace.Arg("rows", (double)rows);
+        trace.Arg("bytes", (double)bytes);
+
+        const void* offset = nullptr;
+        bool from_client = false;
+        if (g_staging.persistent) {
+            GLsync& fence = g_staging.fences[g_staging.slot];
+            if (fence) {
+                if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                    trace.Arg("slot_busy", 1.0);
+                    return false;
+                }
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+            const size_t slot_offset = (size_t)STAGING_SLOT_SIZE * g_staging.slot;
+            std::memcpy(g_staging.mapped + slot_offset, src, bytes);
+            offset = reinterpret_cast<const void*>(slot_offset);
+        }
+        else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, STAGING_SLOT_SIZE, nullptr, GL_STREAM_DRAW);
+            void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (dst) {
+                std::memcpy(dst, src, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            else {
+                // Never upload from the uninitialized buffer; send the rows
+                // from client memory instead.
+                trace.Arg("map_failed", 1.0);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                offset = src;
+                from_client = true;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, upload.textureId);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, upload.x, upload.y + upload.nextRow, upload.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+        if (from_client) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging.buffer);
+        if (g_staging.persistent) {
+            g_staging.fences[g_staging.slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            g_staging.slot = (g_staging.slot + 1) % STAGING_SLOTS;
+        }
+        upload.nextRow += rows;
+        return true;
+    }
+}
+
+GLuint TextureUpload::CreateStreamed(int width, int height, std::vector<unsigned char> pixels) {
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    if (width > 0 && height > 0) {
+        PendingUpload upload;
+        upload.textureId = textureId;
+        upload.width = width;
+        upload.height = height;
+        upload.placeholder = true;
+        upload.pixels = std::move(pixels);
+        g_queue.push_back(std::move(upload));
+        g_placeholders.insert(textureId);
+    }
+    return textureId;
+}
+
+void TextureUpload::UpdateRegion(GLuint textureId, int x, int y, int width, int height, std::vector<unsigned char> pixels) {
+    if (textureId == 0 || width <= 0 || height <= 0) return;
+    PendingUpload upload;
+    upload.textureId = textureId;
+    upload.x = x;
+    upload.y = y;
+    upload.width = width;
+    upload.height = height;
+    upload.pixels = std::move(pixels);
+    g_queue.push_back(std::move(upload));
+}
+
+bool TextureUpload::IsPending(GLuint textureId) {
+    return !g_placeholders.empty() && g_placeholders.count(textureId) != 0;
+}
+
+size_t TextureUpload::PendingCount() {
+    return g_queue.size();
+}
+
+void TextureUpload::Cancel(GLuint textureId) {
+    g_placeholders.erase(textureId);
+    g_queue.erase(std::remove_if(g_queue.begin(), g_queue.end(), [&](const PendingUpload& upload) { return upload.textureId == textureId; }), g_queue.end());
+}
+
+void TextureUpload::Process(float budgetMs) {
+    if (g_queue.empty()) return;
+    init_staging();
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::microseconds((long long)(budgetMs * 1000.0f));
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging.buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    bool first = true;
+    while (!g_queue.empty() && (first || Clock::now() < deadline)) {
+        PendingUpload& upload = g_queue.front();
+        if (!upload_chunk(upload)) break;
+        if (upload.nextRow >= upload.height) {
+            if (upload.placeholder) g_placeholders.erase(upload.textureId);
+            g_queue.pop_front();
+        }
+        first = false;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUpload::Shutdown() {
+    g_queue.clear();
+    g_placeholders.clear();
+    for (GLsync& fence : g_staging.fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (g_staging.buffer != 0) {
+        if (g_staging.persistent) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_staging.buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &g_staging.buffer);
+    }
+    g_staging = StagingBuffer();
+}
\ No newline at end of file
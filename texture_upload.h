@@ -0,0 +1,22 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+
+namespace TextureUpload {
+    // Allocates an RGBA8 texture and queues its pixels for streaming. The id is
+    // valid immediately; its contents arrive over the next frames.
+    GLuint CreateStreamed(int width, int height, std::vector<unsigned char> pixels);
+    // Queues new RGBA8 pixels for a rectangle of an existing texture. The old
+    // contents stay valid meanwhile, so this does not make the texture pending.
+    void UpdateRegion(GLuint textureId, int x, int y, int width, int height, std::vector<unsigned char> pixels);
+    // True while a texture created by CreateStreamed has no contents yet.
+    bool IsPending(GLuint textureId);
+    size_t PendingCount();
+    // Drops queued uploads for a texture that is about to be deleted.
+    void Cancel(GLuint textureId);
+
+    // Streams queued rows through the staging PBO until the budget runs out.
+    // Always makes some progress, even with a zero budget.
+    void Process(float budgetMs);
+    void Shutdown();
+}
\ No newline at end of file
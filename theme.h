@@ -0,0 +1,9 @@
+#pragma once
+#include <imgui.h>
+
+constexpr ImU32 COLOR_HIERARCHY_FRONT = IM_COL32(100, 255, 100, 255);
+constexpr ImU32 COLOR_HIERARCHY_BEHIND = IM_COL32(255, 180, 100, 255);
+constexpr ImVec4 BG_COLOR = ImVec4(0.113f, 0.113f, 0.113f, 1.00f);
+constexpr ImVec4 FRAME_BG_COLOR = ImVec4(0.188f, 0.188f, 0.188f, 1.00f);
+constexpr ImVec4 WIDGET_BG_COLOR = ImVec4(0.227f, 0.227f, 0.227f, 1.00f);
+constexpr ImVec4 TEXT_COLOR = ImVec4(0.878f, 0.878f, 0.878f, 1.00f);
\ No newline at end of file
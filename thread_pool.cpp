@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    class Pool {
+    public:
+        Pool() {
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < count; ++i) {
+                m_workers.emplace_back([this] { WorkerLoop(); });
+            }
+        }
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            for (auto& worker : m_workers) worker.join();
+        }
+
+        unsigned Size() const { return (unsigned)m_workers.size(); }
+
+        void Push(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_wake.notify_one();
+        }
+
+    private:
+        void WorkerLoop() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+                    if (m_stopping && m_tasks.empty()) return;
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+
+    Pool& SharedPool() {
+        static Pool pool;
+        return pool;
+    }
+
+    struct ParallelJob {
+        const std::function<void(size_t)>* fn = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        // Returns false once every index has been claimed.
+        bool RunOne() {
+            size_t index = next.fetch_add(1);
+            if (index >= count) return false;
+            (*fn)(index);
+            if (done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+            return true;
+        }
+    };
+}
+
+unsigned ThreadPool::WorkerCount() {
+    return SharedPool().Size();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1) { fn(0); return; }
+
+    auto job = std::make_shared<ParallelJob>();
+    job->fn = &fn;
+    job->count = count;
+
+    size_t helpers = std::min<size_t>(SharedPool().Size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        SharedPool().Push([job] { while (job->RunOne()) {} });
+    }
+    while (job->RunOne()) {}
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load() == count; });
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    SharedPool().Push(std::move(task));
+}
\ No newline at end of file
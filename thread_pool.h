@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace ThreadPool {
+    unsigned WorkerCount();
+
+    // Runs fn(i) for every i in [0, count). The calling thread takes part, so
+    // nested calls from inside a task cannot deadlock the pool.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    // Fire-and-forget background work.
+    void Submit(std::function<void()> task);
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "trace.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char* name;
+        const char* category;
+        int thread;
+        long long startUs;
+        long long durationUs;
+        std::string args;
+    };
+
+    std::atomic<bool> g_recording{ false };
+    std::mutex g_mutex;
+    std::vector<Event> g_events;
+    Clock::time_point g_origin = Clock::now();
+    std::atomic<int> g_nextThread{ 0 };
+
+    int thread_index() {
+        thread_local int index = g_nextThread++;
+        return index;
+    }
+
+    long long micros_since_origin(Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time - g_origin).count();
+    }
+
+    void append_escaped(std::string& out, const std::string& text) {
+        for (char c : text) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                }
+                else {
+                    out += c;
+                }
+            }
+        }
+    }
+}
+
+void Trace::Start() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_events.clear();
+    g_origin = Clock::now();
+    g_recording = true;
+}
+
+bool Trace::IsRecording() {
+    return g_recording;
+}
+
+bool Trace::Stop(const std::string& path, std::string& errorMessage) {
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_recording = false;
+        events.swap(g_events);
+    }
+
+    std::string json = "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        json += "{\"name\":\"";
+        append_escaped(json, event.name);
+        json += "\",\"cat\":\"";
+        append_escaped(json, event.category);
+        json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.thread);
+        json += ",\"ts\":" + std::to_string(event.startUs) + ",\"dur\":" + std::to_string(event.durationUs);
+        json += ",\"args\":{" + event.args + "}}";
+        json += i + 1 < events.size() ? ",\n" : "\n";
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}\n";
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(json.data(), json.size())) {
+        errorMessage = "Error: Could not write trace " + path;
+        return false;
+    }
+    return true;
+}
+
+Trace::Scope::Scope(const char* name, const char* category)
+    : m_active(g_recording), m_name(name), m_category(category) {
+    if (m_active) m_start = Clock::now();
+}
+
+Trace::Scope::~Scope() {
+    if (!m_active) return;
+    Clock::time_point end = Clock::now();
+    Event event{ m_name, m_category, thread_index(), 0, 0, std::move(m_args) };
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_recording) return;
+    event.startUs = micros_since_origin(m_start);
+    event.durationUs = std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count();
+    g_events.push_back(std::move(event));
+}
+
+void Trace::Scope::Arg(const char* key, const std::string& value) {
+    if (!m_active) return;
+    if (!m_args.empty()) m_args += ',';
+    m_args += '"';
+    append_escaped(m_args, key);
+    m_args += "\":\"";
+    append_escaped(m_args, value);
+    m_args += '"';
+}
+
+void Trace::Scope::Arg(const char* key, double value) {
+    if (!m_active) return;
+    if (!m_args.empty()) m_args += ',';
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.6g", value);
+    m_args += '"';
+    append_escaped(m_args, key);
+    m_args += "\":";
+    m_args += number;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+namespace Trace {
+    // Scoped events are only recorded between Start and Stop. Thread-safe.
+    void Start();
+    bool IsRecording();
+    // Stops recording and writes the events as Chrome trace JSON, viewable in
+    // chrome://tracing or Perfetto.
+    bool Stop(const std::string& path, std::string& errorMessage);
+
+    // One complete event covering the scope's lifetime. Args show up in the
+    // event's detail pane.
+    class Scope {
+    public:
+        Scope(const char* name, const char* category);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void Arg(const char* key, const std::string& value);
+        void Arg(const char* key, double value);
+
+    private:
+        bool m_active;
+        const char* m_name;
+        const char* m_category;
+        std::chrono::steady_clock::time_point m_start;
+        std::string m_args;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "vfs.h"
+#include "environment.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::chrono::seconds RESCAN_INTERVAL(60);
+    const char* INDEX_MAGIC = "PHVFS1";
+
+    struct RootIndex {
+        // Lower-case relative path -> relative path as spelled on disk.
+        std::unordered_map<std::string, std::string> files;
+        // False while the index is the persisted copy from an earlier run,
+        // whose hits still need an existence check.
+        bool verified = false;
+        Clock::time_point scannedAt;
+    };
+
+    std::mutex g_mutex;
+    std::vector<std::string> g_roots;
+    std::map<std::string, std::shared_ptr<const RootIndex>> g_indexes;
+    std::set<std::string> g_scanning;
+    std::atomic<bool> g_shutdown{ false };
+    std::filesystem::path g_cacheDirectory;
+
+    std::string to_key(std::string path) {
+        std::replace(path.begin(), path.end(), '\\', '/');
+        path = std::filesystem::path(path).lexically_normal().generic_string();
+        while (path.rfind("./", 0) == 0) path.erase(0, 2);
+        std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return path;
+    }
+
+    std::filesystem::path index_file_for(const std::string& root) {
+        unsigned long long hash = 14695981039346656037ull;
+        for (unsigned char c : root) { hash ^= c; hash *= 1099511628211ull; }
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.idx", hash);
+        return g_cacheDirectory / name;
+    }
+
+    std::shared_ptr<RootIndex> load_persisted(const std::string& root) {
+        std::ifstream in(index_file_for(root));
+        std::string magic, stored_root;
+        if (!std::getline(in, magic) || magic != INDEX_MAGIC || !std::getline(in, stored_root) || stored_root != root) return nullptr;
+        auto index = std::make_shared<RootIndex>();
+        for (std::string relative; std::getline(in, relative);) {
+            if (!relative.empty()) index->files.emplace(to_key(relative), relative);
+        }
+        return index;
+    }
+
+    void save_persisted(const std::string& root, const RootIndex& index) {
+        std::error_code ec;
+        std::filesystem::create_directories(g_cacheDirectory, ec);
+        std::filesystem::path target = index_file_for(root);
+        std::filesystem::path temp = target;
+        temp += ".tmp";
+        {
+            std::ofstream out(temp, std::ios::trunc);
+            if (!out.is_open()) return;
+            out << INDEX_MAGIC << '\n' << root << '\n';
+            for (const auto& [key, relative] : index.files) out << relative << '\n';
+            if (!out) return;
+        }
+        std::filesystem::rename(temp, target, ec);
+    }
+
+    // Returns null if shutdown interrupted the scan.
+    std::shared_ptr<RootIndex> scan_root(const std::string& root) {
+        auto index = std::make_shared<RootIndex>();
+        std::error_code ec;
+        const std::filesystem::path root_path(root);
+        std::filesystem::recursive_directory_iterator it(root_path, std::filesystem::directory_options::skip_permission_denied, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            if (g_shutdown) return nullptr;
+            std::error_code type_ec;
+            if (!it->is_regular_file(type_ec)) continue;
+            std::string relative = it->path().lexically_relative(root_path).generic_string();
+            index->files.emplace(to_key(relative), std::move(relative));
+        }
+        index->verified = true;
+        index->scannedAt = Clock::now();
+        return index;
+    }
+
+    void publish(const std::string& root, std::shared_ptr<const RootIndex> index) {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_indexes[root] = std::move(index);
+    }
+
+    void index_root(const std::string& root) {
+        bool have_index;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            have_index = g_indexes.count(root) > 0;
+        }
+        if (!have_index) {
+            if (auto persisted = load_persisted(root)) publish(root, persisted);
+        }
+        if (auto scanned = scan_root(root)) {
+            save_persisted(root, *scanned);
+            publish(root, scanned);
+        }
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_scanning.erase(root);
+    }
+
+    // Looks one key up in one root; roots without an index are probed on disk.
+    bool lookup(const std::string& root, const RootIndex* index, const std::string& key, const std::string& original, std::filesystem::path& out) {
+        if (!index) {
+            std::filesystem::path full_path = (std::filesystem::path(root) / original).lexically_normal();
+            std::error_code ec;
+            if (!std::filesystem::exists(full_path, ec)) return false;
+            out = full_path;
+            return true;
+        }
+        auto it = index->files.find(key);
+        if (it == index->files.end()) return false;
+        std::filesystem::path full_path = (std::filesystem::path(root) / it->second).lexically_normal();
+        std::error_code ec;
+        if (!index->verified && !std::filesystem::exists(full_path, ec)) return false;
+        out = full_path;
+        return true;
+    }
+}
+
+void Vfs::Mount(const std::vector<std::string>& roots) {
+    std::vector<std::string> to_scan;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_cacheDirectory.empty()) g_cacheDirectory = Environment::CacheDirectory("vfs");
+        g_roots = roots;
+        for (const auto& root : roots) {
+            if (root.empty() || g_scanning.count(root)) continue;
+            auto it = g_indexes.find(root);
+            if (it != g_indexes.end() && it->second->verified && Clock::now() - it->second->scannedAt < RESCAN_INTERVAL) continue;
+            g_scanning.insert(root);
+            to_scan.push_back(root);
+        }
+    }
+    for (const auto& root : to_scan) {
+        ThreadPool::Submit([root] { index_root(root); });
+    }
+}
+
+void Vfs::IndexNow(const std::vector<std::string>& roots) {
+    std::vector<std::string> to_scan;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_cacheDirectory.empty()) g_cacheDirectory = Environment::CacheDirectory("vfs");
+        for (const auto& root : roots) {
+            if (root.empty() || g_scanning.count(root)) continue;
+            auto it = g_indexes.find(root);
+            if (it != g_indexes.end() && it->second->verified) continue;
+            g_scanning.insert(root);
+            to_scan.push_back(root);
+        }
+    }
+    ThreadPool::ParallelFor(to_scan.size(), [&](size_t i) { index_root(to_scan[i]); });
+
+    // Roots a background Mount was already scanning are waited for as well.
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            if (std::none_of(roots.begin(), roots.end(), [](const std::string& root) { return g_scanning.count(root) > 0; })) return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+std::filesystem::path Vfs::Resolve(const std::string& path, const std::vector<std::string>& fallbackExtensions) {
+    std::vector<std::string> roots;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        roots = g_roots;
+    }
+    return Resolve(path, roots, fallbackExtensions);
+}
+
+std::filesystem::path Vfs::Resolve(const std::string& path, const std::vector<std::string>& searchRoots, const std::vector<std::string>& fallbackExtensions) {
+    std::filesystem::path file_path(path);
+    if (file_path.empty()) return "";
+    std::error_code ec;
+    if (file_path.is_absolute()) {
+        if (std::filesystem::exists(file_path, ec)) return file_path.lexically_normal();
+        for (const auto& extension : fallbackExtensions) {
+            std::filesystem::path candidate = file_path;
+            candidate.replace_extension(extension);
+            if (std::filesystem::exists(candidate, ec)) return candidate.lexically_normal();
+        }
+        return "";
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<const RootIndex>>> roots;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (const auto& root : searchRoots) {
+            auto it = g_indexes.find(root);
+            roots.push_back({ root, it == g_indexes.end() ? nullptr : it->second });
+        }
+    }
+
+    std::filesystem::path found;
+    const std::string key = to_key(path);
+    for (const auto& [root, index] : roots) {
+        if (lookup(root, index.get(), key, path, found)) return found;
+    }
+
+    std::filesystem::path stem_path(path);
+    stem_path.replace_extension();
+    const std::string stem_key = std::filesystem::path(key).replace_extension().generic_string();
+    for (const auto& extension : fallbackExtensions) {
+        std::string original = stem_path.string() + extension;
+        std::string extension_key = stem_key + to_key(extension);
+        for (const auto& [root, index] : roots) {
+            if (lookup(root, index.get(), extension_key, original, found)) return found;
+        }
+    }
+
+    // Indexed roots are rescanned on Mount once RESCAN_INTERVAL has passed, so
+    // a miss is not confirmed on disk; files created since then turn up after
+    // the next scan.
+    return "";
+}
+
+void Vfs::Shutdown() {
+    g_shutdown = true;
+}
\ No newline at end of file
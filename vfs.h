@@ -0,0 +1,28 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Vfs {
+    // Overlays the roots in priority order (mod before Forts data). Each root
+    // is indexed on the thread pool; a persisted copy of the last index is
+    // used meanwhile, and roots without any index are probed on disk.
+    void Mount(const std::vector<std::string>& roots);
+
+    // Case-insensitive lookup of a root-relative (or absolute) path. When the
+    // exact file is missing, the same stem is tried with each fallback
+    // extension in order. Returns an empty path if nothing matches.
+    // Safe to call from worker threads.
+    std::filesystem::path Resolve(const std::string& path, const std::vector<std::string>& fallbackExtensions = {});
+
+    // Same lookup against explicit roots instead of the mounted ones, so
+    // scripts from different mods can be resolved side by side.
+    std::filesystem::path Resolve(const std::string& path, const std::vector<std::string>& searchRoots, const std::vector<std::string>& fallbackExtensions);
+
+    // Builds the index of every root that lacks a fresh one and waits for it,
+    // for headless runs that resolve many files right away.
+    void IndexNow(const std::vector<std::string>& roots);
+
+    // Stops background indexing so shutdown does not wait for a full scan.
+    void Shutdown();
+}
\ No newline at end of file